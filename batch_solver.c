@@ -0,0 +1,397 @@
+#define _DEFAULT_SOURCE
+#include "batch_solver.h"
+#include "input_validator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// 取消尺寸上限的命令行选项，与单文件模式一致
+#define BATCH_LARGE_OPTION "--large"
+
+// 错误信息的前缀，输出原因时去掉
+#define ERROR_PREFIX "错误："
+
+// 工作线程共享的任务队列
+typedef struct {
+    const BatchJobList* list;
+    BatchResult* results;
+    size_t nextJob;             // 下一个待领取的任务，原子递增
+    size_t nextOutput;          // 下一个待输出的结果，按任务顺序输出
+    pthread_mutex_t outputLock; // 保护输出顺序
+    MazeCache cache;            // 清单中重复出现的迷宫共用一次加载和求解结果
+} BatchQueue;
+
+/**
+ * 检查命令行是否请求批量模式
+ *
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数
+ * @return 第一个参数是批量模式选项时返回true
+ */
+bool isBatchCommandLine(int argc, char *argv[]) {
+    return argc >= 2 && strcmp(argv[1], BATCH_MODE_OPTION) == 0;
+}
+
+/**
+ * 向任务列表追加一个迷宫文件
+ */
+static bool addBatchJob(BatchJobList *list, const char *path, int width, int height) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 64;
+        BatchJob *jobs = (BatchJob*)realloc(list->jobs, capacity * sizeof(BatchJob));
+        if (!jobs) {
+            return false;
+        }
+        list->jobs = jobs;
+        list->capacity = capacity;
+    }
+
+    char *copy = strdup(path);
+    if (!copy) {
+        return false;
+    }
+    list->jobs[list->count].path = copy;
+    list->jobs[list->count].width = width;
+    list->jobs[list->count].height = height;
+    list->count++;
+    return true;
+}
+
+/**
+ * 按路径排序，使目录模式的输出顺序固定
+ */
+static int compareBatchJobs(const void *a, const void *b) {
+    return strcmp(((const BatchJob*)a)->path, ((const BatchJob*)b)->path);
+}
+
+/**
+ * 收集目录中所有 .txt 普通文件
+ */
+static bool loadBatchDirectory(const char *directory, BatchJobList *list) {
+    DIR *dir = opendir(directory);
+    if (!dir) {
+        printf("错误：无法打开目录 %s\n", directory);
+        return false;
+    }
+
+    bool ok = true;
+    struct dirent *entry;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        size_t nameLen = strlen(entry->d_name);
+        if (nameLen < 5 || strcmp(entry->d_name + nameLen - 4, ".txt") != 0) {
+            continue;
+        }
+
+        size_t pathLen = strlen(directory) + 1 + nameLen + 1;
+        char *path = (char*)malloc(pathLen);
+        if (!path) {
+            printf("错误：内存分配失败\n");
+            ok = false;
+            break;
+        }
+        snprintf(path, pathLen, "%s/%s", directory, entry->d_name);
+
+        struct stat st;
+        if (stat(path, &st) == 0 && S_ISREG(st.st_mode) && !addBatchJob(list, path, 0, 0)) {
+            printf("错误：内存分配失败\n");
+            ok = false;
+        }
+        free(path);
+    }
+    closedir(dir);
+
+    if (ok && list->count > 0) {
+        qsort(list->jobs, list->count, sizeof(BatchJob), compareBatchJobs);
+    }
+    return ok;
+}
+
+/**
+ * 读取清单文件，每行为“路径 [宽度 高度]”，空行和以 # 开头的行忽略
+ */
+static bool loadBatchManifest(const char *manifest, BatchJobList *list) {
+    FILE *file = fopen(manifest, "r");
+    if (!file) {
+        printf("错误：无法打开清单文件 %s\n", manifest);
+        return false;
+    }
+
+    char *line = NULL;
+    size_t lineCapacity = 0;
+    ssize_t lineLen;
+    int lineNumber = 0;
+    bool ok = true;
+
+    while (ok && (lineLen = getline(&line, &lineCapacity, file)) != -1) {
+        lineNumber++;
+        while (lineLen > 0 && (line[lineLen - 1] == '\n' || line[lineLen - 1] == '\r')) {
+            line[--lineLen] = '\0';
+        }
+
+        char *path = line + strspn(line, " \t");
+        if (*path == '\0' || *path == '#') {
+            continue;
+        }
+
+        // 路径后面可以跟宽度和高度，省略时从文件推断
+        char *rest = path + strcspn(path, " \t");
+        int width = 0;
+        int height = 0;
+        if (*rest != '\0') {
+            *rest++ = '\0';
+            char extra;
+            int fields = sscanf(rest, "%d %d %c", &width, &height, &extra);
+            if (fields == EOF) {
+                width = 0;
+                height = 0;
+            } else if (fields != 2 || width <= 0 || height <= 0) {
+                printf("错误：清单第%d行格式不正确\n", lineNumber);
+                ok = false;
+                break;
+            }
+        }
+
+        if (!addBatchJob(list, path, width, height)) {
+            printf("错误：内存分配失败\n");
+            ok = false;
+        }
+    }
+
+    free(line);
+    fclose(file);
+    return ok;
+}
+
+/**
+ * 从目录或清单文件收集批量任务
+ *
+ * @param source 目录（处理其中所有 .txt 文件）或清单文件
+ * @param list 任务列表，需已清零
+ * @return 成功返回true，否则返回false
+ */
+bool loadBatchJobs(const char *source, BatchJobList *list) {
+    struct stat st;
+    if (stat(source, &st) != 0) {
+        printf("错误：无法打开 %s\n", source);
+        return false;
+    }
+
+    bool ok = S_ISDIR(st.st_mode) ? loadBatchDirectory(source, list)
+                                  : loadBatchManifest(source, list);
+    if (!ok) {
+        freeBatchJobs(list);
+    }
+    return ok;
+}
+
+/**
+ * 释放批量任务列表
+ *
+ * @param list 任务列表
+ */
+void freeBatchJobs(BatchJobList *list) {
+    for (size_t i = 0; i < list->count; i++) {
+        free(list->jobs[i].path);
+    }
+    free(list->jobs);
+    list->jobs = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+/**
+ * 取得单调时钟的微秒数
+ */
+static long currentMicros(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+/**
+ * 加载、验证并求解一个迷宫文件
+ *
+ * 验证过程中的错误信息写入结果的原因字段，不打印。
+ * 使用缓存时文件未改变的迷宫直接取缓存的可达性和最短路径长度。
+ *
+ * @param job 迷宫文件及其尺寸
+ * @param cache 迷宫缓存，NULL 表示每次都重新加载
+ * @param workspace 本线程复用的BFS工作区
+ * @param result 输出处理结果
+ */
+void solveBatchJob(const BatchJob *job, MazeCache *cache, BfsWorkspace *workspace, BatchResult *result) {
+    long begin = currentMicros();
+    result->valid = false;
+    result->reachable = false;
+    result->length = -1;
+    captureMazeErrors(result->reason, sizeof(result->reason));
+
+    int width = job->width;
+    int height = job->height;
+    if ((width > 0 || detectMazeDimensions(job->path, &width, &height)) &&
+        validateMazeSize(width, height)) {
+        const CachedMaze *entry = cache ? acquireCachedMaze(cache, job->path, width, height, workspace) : NULL;
+        Maze *maze = cache ? NULL : createMaze(job->path, width, height);
+        if (entry) {
+            result->valid = true;
+            result->length = entry->shortestPath;
+            result->reachable = entry->reachable;
+            releaseCachedMaze(cache, entry);
+        } else if (maze) {
+            result->valid = true;
+            result->length = calculateShortestPathLengthWith(maze, workspace, BFS_FORWARD);
+            result->reachable = result->length >= 0;
+            freeMaze(maze);
+        } else if (result->reason[0] == '\0') {
+            reportMazeError("错误：内存分配失败\n");
+        }
+    }
+
+    captureMazeErrors(NULL, 0);
+    result->micros = currentMicros() - begin;
+}
+
+/**
+ * 输出一行结果
+ *
+ * 各列以制表符分隔：路径、valid/invalid、reachable/unreachable/-、
+ * 最短路径长度、耗时（微秒）、无效原因（有效时为 -）。
+ *
+ * @param job 迷宫文件
+ * @param result 处理结果
+ */
+void printBatchResult(const BatchJob *job, const BatchResult *result) {
+    const char *reason = "-";
+    if (!result->valid) {
+        reason = result->reason;
+        if (strncmp(reason, ERROR_PREFIX, strlen(ERROR_PREFIX)) == 0) {
+            reason += strlen(ERROR_PREFIX);
+        }
+    }
+
+    printf("%s\t%s\t%s\t%d\t%ld\t%s\n", job->path,
+           result->valid ? "valid" : "invalid",
+           result->valid ? (result->reachable ? "reachable" : "unreachable") : "-",
+           result->length, result->micros, reason);
+}
+
+/**
+ * 工作线程：不断领取任务，并按任务顺序输出已完成的结果
+ */
+static void* runBatchWorker(void *arg) {
+    BatchQueue *queue = (BatchQueue*)arg;
+    const BatchJobList *list = queue->list;
+    BfsWorkspace workspace;
+    initBfsWorkspace(&workspace);
+
+    for (;;) {
+        size_t index = __atomic_fetch_add(&queue->nextJob, 1, __ATOMIC_RELAXED);
+        if (index >= list->count) {
+            break;
+        }
+        solveBatchJob(&list->jobs[index], &queue->cache, &workspace, &queue->results[index]);
+
+        // 输出从 nextOutput 开始连续完成的结果，保持与任务列表相同的顺序
+        pthread_mutex_lock(&queue->outputLock);
+        queue->results[index].finished = true;
+        while (queue->nextOutput < list->count && queue->results[queue->nextOutput].finished) {
+            printBatchResult(&list->jobs[queue->nextOutput], &queue->results[queue->nextOutput]);
+            queue->nextOutput++;
+        }
+        pthread_mutex_unlock(&queue->outputLock);
+    }
+
+    freeBfsWorkspace(&workspace);
+    return NULL;
+}
+
+/**
+ * 运行批量模式
+ *
+ * 用法：<程序> --batch <目录或清单文件> [线程数] [--large]
+ * 每个迷宫输出一行结果，顺序与目录排序或清单顺序一致。
+ *
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数
+ * @return 全部处理完返回0，参数或任务列表有误返回1
+ */
+int runBatchMode(int argc, char *argv[]) {
+    if (argc < 3 || argc > 5) {
+        printf("错误：命令行参数数量不正确\n");
+        printf("用法: %s %s <目录或清单文件> [线程数] [%s]\n", argv[0], BATCH_MODE_OPTION, BATCH_LARGE_OPTION);
+        return 1;
+    }
+
+    // 解析可选的线程数和大迷宫选项
+    int threadCount = 0;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], BATCH_LARGE_OPTION) == 0) {
+            setMazeSizeLimits(MIN_MAZE_SIZE, UNLIMITED_MAZE_SIZE);
+        } else {
+            char *end = NULL;
+            long value = strtol(argv[i], &end, 10);
+            if (end == argv[i] || *end != '\0' || value <= 0 || value > INT_MAX) {
+                printf("错误：未知选项 %s\n", argv[i]);
+                return 1;
+            }
+            if (threadCount > 0) {
+                printf("错误：线程数重复指定 %s\n", argv[i]);
+                return 1;
+            }
+            threadCount = (int)value;
+        }
+    }
+    if (threadCount <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cpus > 0 ? (int)cpus : 1;
+    }
+
+    BatchJobList list = {NULL, 0, 0};
+    if (!loadBatchJobs(argv[2], &list)) {
+        return 1;
+    }
+    if ((size_t)threadCount > list.count) {
+        threadCount = list.count > 0 ? (int)list.count : 1;
+    }
+
+    BatchQueue queue;
+    queue.list = &list;
+    queue.results = (BatchResult*)calloc(list.count > 0 ? list.count : 1, sizeof(BatchResult));
+    queue.nextJob = 0;
+    queue.nextOutput = 0;
+    pthread_t *threads = (pthread_t*)calloc(threadCount, sizeof(pthread_t));
+    if (!queue.results || !threads || !initMazeCache(&queue.cache, MAZE_CACHE_DEFAULT_BUDGET)) {
+        printf("错误：内存分配失败\n");
+        free(queue.results);
+        free(threads);
+        freeBatchJobs(&list);
+        return 1;
+    }
+    pthread_mutex_init(&queue.outputLock, NULL);
+
+    // 调用线程也作为一个工作线程，线程创建失败时由已有线程处理剩余任务
+    int started = 0;
+    for (int t = 1; t < threadCount; t++) {
+        if (pthread_create(&threads[started], NULL, runBatchWorker, &queue) != 0) {
+            break;
+        }
+        started++;
+    }
+    runBatchWorker(&queue);
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    pthread_mutex_destroy(&queue.outputLock);
+    freeMazeCache(&queue.cache);
+    free(queue.results);
+    free(threads);
+    freeBatchJobs(&list);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#ifndef BATCH_SOLVER_H
+#define BATCH_SOLVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "path_finder.h"
+#include "maze_cache.h"
+
+// 开启批量模式的命令行选项
+#define BATCH_MODE_OPTION "--batch"
+
+// 失败原因缓冲区大小
+#define BATCH_REASON_SIZE 160
+
+// 批量任务中的一个迷宫文件
+typedef struct {
+    char* path;         // 迷宫文件路径
+    int width;          // 迷宫宽度，0 表示从文件推断
+    int height;         // 迷宫高度，0 表示从文件推断
+} BatchJob;
+
+// 批量任务列表
+typedef struct {
+    BatchJob* jobs;
+    size_t count;
+    size_t capacity;
+} BatchJobList;
+
+// 单个迷宫的处理结果
+typedef struct {
+    bool valid;                     // 是否通过结构验证
+    bool reachable;                 // 终点是否可达
+    int length;                     // 最短路径长度，不可达或无效为-1
+    long micros;                    // 加载、验证和求解耗时（微秒）
+    char reason[BATCH_REASON_SIZE]; // 无效时的原因
+    bool finished;                  // 是否已处理完
+} BatchResult;
+
+// 检查命令行是否请求批量模式
+bool isBatchCommandLine(int argc, char *argv[]);
+
+// 运行批量模式，返回程序退出码
+int runBatchMode(int argc, char *argv[]);
+
+// 从目录或清单文件收集批量任务
+bool loadBatchJobs(const char *source, BatchJobList *list);
+
+// 释放批量任务列表
+void freeBatchJobs(BatchJobList *list);
+
+// 加载、验证并求解一个迷宫文件，cache 不为 NULL 时重复出现的迷宫只处理一次
+void solveBatchJob(const BatchJob *job, MazeCache *cache, BfsWorkspace *workspace, BatchResult *result);
+
+// 输出一行结果
+void printBatchResult(const BatchJob *job, const BatchResult *result);
+
+#endif /* BATCH_SOLVER_H */
@@ -0,0 +1,529 @@
+#include "corridor_graph.h"
+#include "large_buffer.h"
+
+// 不可达的距离
+#define CORRIDOR_INFINITY UINT32_MAX
+
+// 查询点所在走廊两端最多两个节点
+#define CORRIDOR_MAX_ANCHORS 2
+
+// 查询点沿走廊到附近节点的一段路
+typedef struct {
+    uint32_t node;      // 到达的节点
+    uint32_t distance;  // 步数
+    int move;           // 从查询点出发的第一步方向，查询点本身是节点时为-1
+} CorridorAnchor;
+
+// 一次查询的结果，展开路径时使用
+typedef struct {
+    uint32_t distance;  // 最短距离，不可达为 CORRIDOR_INFINITY
+    int directMove;     // 两点在同一条走廊上且直接走过去最短时的第一步方向，否则为-1
+    uint32_t lastNode;  // 经过图时最后到达的节点
+    int endAnchor;      // 从最后的节点走到终点用的那段路
+    CorridorAnchor startAnchors[CORRIDOR_MAX_ANCHORS];
+    int startCount;
+    CorridorAnchor endAnchors[CORRIDOR_MAX_ANCHORS];
+    int endCount;
+} CorridorRoute;
+
+/**
+ * 走廊格子沿来向继续走的下一步方向
+ *
+ * 非节点的可通行格子恰好有两个可移动方向，去掉来时的方向只剩一个。
+ */
+static int nextCorridorMove(const Maze *maze, CellIndex cell, int move) {
+    return __builtin_ctz(maze->moveMasks[cell] & ~MOVE_BIT(move ^ 1));
+}
+
+/**
+ * 从格子出发先走 move，沿走廊走到节点、stop 或回到出发格子为止
+ *
+ * @return 走过的步数，到达的格子写入 reached
+ */
+static uint32_t walkCorridor(const CorridorGraph *graph, CellIndex cell, int move, CellIndex stop, CellIndex *reached) {
+    const Maze *maze = graph->maze;
+    CellIndex current = cell;
+    uint32_t steps = 0;
+    for (;;) {
+        current += maze->moveOffsets[move];
+        steps++;
+        if (current == stop || graph->nodeIds[current] || current == cell) {
+            break;
+        }
+        move = nextCorridorMove(maze, current, move);
+    }
+    *reached = current;
+    return steps;
+}
+
+/**
+ * 把迷宫的走廊压缩成加权图
+ *
+ * 可移动方向数不等于2的可通行格子（岔路口、死胡同）以及起点和终点作为节点，
+ * 其余格子都在两节点之间的走廊上。从每个节点沿每个方向走到下一个节点得到一条边，
+ * 每条走廊因此正反各记一次。没有任何节点的环形走廊不进入图。
+ *
+ * @param graph 输出的走廊图，使用后调用 freeCorridorGraph 释放
+ * @param maze 指向迷宫结构体的指针，走廊图使用期间不能修改
+ * @return 成功返回true，内存不足或格子数超出32位编号范围时返回false
+ */
+bool buildCorridorGraph(CorridorGraph *graph, const Maze *maze) {
+    memset(graph, 0, sizeof(CorridorGraph));
+    graph->maze = maze;
+    size_t cellCount = MAZE_CELL_COUNT(maze);
+    if (cellCount > UINT32_MAX) {
+        return false;
+    }
+    graph->cellCount = cellCount;
+    graph->nodeIds = (uint32_t*)allocateBuffer(cellCount * sizeof(uint32_t));
+    if (!graph->nodeIds) {
+        return false;
+    }
+
+    // 先为节点编号并统计边数
+    CellIndex startCell = MAZE_INDEX(maze, maze->start.row, maze->start.col);
+    CellIndex exitCell = MAZE_INDEX(maze, maze->exit.row, maze->exit.col);
+    uint32_t nodeCount = 0;
+    size_t edgeCount = 0;
+    for (int i = 0; i < maze->height; i++) {
+        CellIndex index = MAZE_INDEX(maze, i, 0);
+        for (int j = 0; j < maze->width; j++, index++) {
+            if (!IS_OPEN_CELL(maze->cells[index])) {
+                continue;
+            }
+            int degree = __builtin_popcount(maze->moveMasks[index]);
+            if (degree != 2 || index == startCell || index == exitCell) {
+                graph->nodeIds[index] = ++nodeCount;
+                edgeCount += (size_t)degree;
+            }
+        }
+    }
+    if (edgeCount > UINT32_MAX) {
+        freeCorridorGraph(graph);
+        return false;
+    }
+
+    graph->nodeCount = nodeCount;
+    graph->edgeCount = (uint32_t)edgeCount;
+    graph->nodeCells = (CellIndex*)malloc((nodeCount > 0 ? nodeCount : 1) * sizeof(CellIndex));
+    graph->offsets = (uint32_t*)malloc(((size_t)nodeCount + 1) * sizeof(uint32_t));
+    graph->targets = (uint32_t*)malloc((edgeCount > 0 ? edgeCount : 1) * sizeof(uint32_t));
+    graph->weights = (uint32_t*)malloc((edgeCount > 0 ? edgeCount : 1) * sizeof(uint32_t));
+    graph->moves = (uint8_t*)malloc(edgeCount > 0 ? edgeCount : 1);
+    if (!graph->nodeCells || !graph->offsets || !graph->targets || !graph->weights || !graph->moves) {
+        freeCorridorGraph(graph);
+        return false;
+    }
+
+    uint32_t node = 0;
+    graph->offsets[0] = 0;
+    for (int i = 0; i < maze->height; i++) {
+        CellIndex index = MAZE_INDEX(maze, i, 0);
+        for (int j = 0; j < maze->width; j++, index++) {
+            if (graph->nodeIds[index]) {
+                graph->nodeCells[node] = index;
+                graph->offsets[node + 1] = graph->offsets[node] + __builtin_popcount(maze->moveMasks[index]);
+                node++;
+            }
+        }
+    }
+
+    // 沿每个节点的每个方向走到下一个节点
+    for (node = 0; node < nodeCount; node++) {
+        CellIndex cell = graph->nodeCells[node];
+        uint32_t edge = graph->offsets[node];
+        for (unsigned mask = maze->moveMasks[cell]; mask; mask &= mask - 1) {
+            int move = __builtin_ctz(mask);
+            CellIndex reached;
+            graph->weights[edge] = walkCorridor(graph, cell, move, -1, &reached);
+            graph->targets[edge] = graph->nodeIds[reached] - 1;
+            graph->moves[edge] = (uint8_t)move;
+            edge++;
+        }
+    }
+    return true;
+}
+
+/**
+ * 释放走廊图
+ *
+ * @param graph 指向走廊图的指针
+ */
+void freeCorridorGraph(CorridorGraph *graph) {
+    releaseBuffer(graph->nodeIds, graph->cellCount * sizeof(uint32_t));
+    free(graph->nodeCells);
+    free(graph->offsets);
+    free(graph->targets);
+    free(graph->weights);
+    free(graph->moves);
+    memset(graph, 0, sizeof(CorridorGraph));
+}
+
+/**
+ * 初始化走廊图搜索工作区，缓冲区在第一次查询时分配
+ *
+ * @param search 指向工作区的指针
+ */
+void initCorridorSearch(CorridorSearch *search) {
+    memset(search, 0, sizeof(CorridorSearch));
+}
+
+/**
+ * 释放走廊图搜索工作区
+ *
+ * @param search 指向工作区的指针
+ */
+void freeCorridorSearch(CorridorSearch *search) {
+    size_t bytes = search->capacity * sizeof(uint32_t);
+    releaseBuffer(search->distances, bytes);
+    releaseBuffer(search->stamps, bytes);
+    releaseBuffer(search->previous, bytes);
+    releaseBuffer(search->edges, bytes);
+    free(search->heap);
+    memset(search, 0, sizeof(CorridorSearch));
+}
+
+/**
+ * 确保工作区能容纳图的所有节点
+ */
+static bool reserveCorridorSearch(CorridorSearch *search, uint32_t nodeCount) {
+    if (search->capacity >= nodeCount && search->capacity > 0) {
+        return true;
+    }
+    freeCorridorSearch(search);
+
+    size_t capacity = nodeCount > 0 ? nodeCount : 1;
+    size_t bytes = capacity * sizeof(uint32_t);
+    search->distances = (uint32_t*)allocateBuffer(bytes);
+    search->stamps = (uint32_t*)allocateBuffer(bytes);
+    search->previous = (uint32_t*)allocateBuffer(bytes);
+    search->edges = (uint32_t*)allocateBuffer(bytes);
+    search->capacity = capacity;
+    if (!search->distances || !search->stamps || !search->previous || !search->edges) {
+        freeCorridorSearch(search);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 向二叉堆中加入一个节点
+ */
+static bool pushCorridorHeap(CorridorSearch *search, size_t *size, uint32_t distance, uint32_t node) {
+    if (*size == search->heapCapacity) {
+        size_t capacity = search->heapCapacity ? search->heapCapacity * 2 : 256;
+        CorridorHeapEntry *heap = (CorridorHeapEntry*)realloc(search->heap, capacity * sizeof(CorridorHeapEntry));
+        if (!heap) {
+            return false;
+        }
+        search->heap = heap;
+        search->heapCapacity = capacity;
+    }
+
+    CorridorHeapEntry *heap = search->heap;
+    size_t child = (*size)++;
+    while (child > 0) {
+        size_t parent = (child - 1) / 2;
+        if (heap[parent].distance <= distance) {
+            break;
+        }
+        heap[child] = heap[parent];
+        child = parent;
+    }
+    heap[child].distance = distance;
+    heap[child].node = node;
+    return true;
+}
+
+/**
+ * 取出二叉堆中距离最小的节点
+ */
+static CorridorHeapEntry popCorridorHeap(CorridorSearch *search, size_t *size) {
+    CorridorHeapEntry *heap = search->heap;
+    CorridorHeapEntry top = heap[0];
+    CorridorHeapEntry last = heap[--(*size)];
+    size_t parent = 0;
+    for (;;) {
+        size_t child = 2 * parent + 1;
+        if (child >= *size) {
+            break;
+        }
+        if (child + 1 < *size && heap[child + 1].distance < heap[child].distance) {
+            child++;
+        }
+        if (last.distance <= heap[child].distance) {
+            break;
+        }
+        heap[parent] = heap[child];
+        parent = child;
+    }
+    if (*size > 0) {
+        heap[parent] = last;
+    }
+    return top;
+}
+
+/**
+ * 找出查询点所在走廊两端的节点
+ *
+ * 查询点本身是节点时只有它自己。沿走廊先遇到 stop 时不再往前走，
+ * 改为记录直达 stop 的步数和第一步方向。
+ */
+static int findCorridorAnchors(const CorridorGraph *graph, CellIndex cell, CellIndex stop,
+                               CorridorAnchor *anchors, uint32_t *direct, int *directMove) {
+    if (graph->nodeIds[cell]) {
+        anchors[0].node = graph->nodeIds[cell] - 1;
+        anchors[0].distance = 0;
+        anchors[0].move = -1;
+        return 1;
+    }
+
+    int count = 0;
+    for (unsigned mask = graph->maze->moveMasks[cell]; mask; mask &= mask - 1) {
+        int move = __builtin_ctz(mask);
+        CellIndex reached;
+        uint32_t steps = walkCorridor(graph, cell, move, stop, &reached);
+        if (reached == stop) {
+            if (steps < *direct) {
+                *direct = steps;
+                *directMove = move;
+            }
+        } else if (reached != cell) {
+            anchors[count].node = graph->nodeIds[reached] - 1;
+            anchors[count].distance = steps;
+            anchors[count].move = move;
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * 更新节点的距离并放入堆
+ */
+static bool relaxCorridorNode(CorridorSearch *search, size_t *heapSize, uint32_t node, uint32_t distance,
+                              uint32_t previous, uint32_t edge) {
+    if (search->stamps[node] == search->stamp && search->distances[node] <= distance) {
+        return true;
+    }
+    search->stamps[node] = search->stamp;
+    search->distances[node] = distance;
+    search->previous[node] = previous;
+    search->edges[node] = edge;
+    return pushCorridorHeap(search, heapSize, distance, node);
+}
+
+/**
+ * 在走廊图上求两点间的最短路线
+ *
+ * 起点和终点不是节点时先沿所在走廊走到两端的节点，再从起点一侧的节点做 Dijkstra，
+ * 弹出的距离不小于已知最好结果时停止。两点在同一条走廊上时直接走过去也是候选。
+ *
+ * @return 参数有效且内存足够返回true，是否可达看 route->distance
+ */
+static bool routeCorridor(const CorridorGraph *graph, CorridorSearch *search, Position start, Position end,
+                          CorridorRoute *route) {
+    const Maze *maze = graph->maze;
+    route->distance = CORRIDOR_INFINITY;
+    route->directMove = -1;
+    route->startCount = 0;
+    route->endCount = 0;
+    if (start.row < 0 || start.row >= maze->height || start.col < 0 || start.col >= maze->width ||
+        end.row < 0 || end.row >= maze->height || end.col < 0 || end.col >= maze->width) {
+        return false;
+    }
+    CellIndex startCell = MAZE_INDEX(maze, start.row, start.col);
+    CellIndex endCell = MAZE_INDEX(maze, end.row, end.col);
+    if (!IS_OPEN_CELL(maze->cells[startCell]) || !IS_OPEN_CELL(maze->cells[endCell])) {
+        return false;
+    }
+    if (startCell == endCell) {
+        route->distance = 0;
+        return true;
+    }
+
+    route->startCount = findCorridorAnchors(graph, startCell, endCell, route->startAnchors,
+                                            &route->distance, &route->directMove);
+    // 终点一侧不设 stop：起点是节点时经由它到终点的那段路也要作为入口
+    uint32_t unused = CORRIDOR_INFINITY;
+    int unusedMove = -1;
+    route->endCount = findCorridorAnchors(graph, endCell, -1, route->endAnchors, &unused, &unusedMove);
+    if (route->startCount == 0 || route->endCount == 0) {
+        return true;
+    }
+
+    if (!reserveCorridorSearch(search, graph->nodeCount)) {
+        return false;
+    }
+    if (++search->stamp == 0) {
+        memset(search->stamps, 0, search->capacity * sizeof(uint32_t));
+        search->stamp = 1;
+    }
+
+    size_t heapSize = 0;
+    for (int a = 0; a < route->startCount; a++) {
+        if (!relaxCorridorNode(search, &heapSize, route->startAnchors[a].node, route->startAnchors[a].distance,
+                               CORRIDOR_NO_EDGE, CORRIDOR_NO_EDGE)) {
+            return false;
+        }
+    }
+
+    while (heapSize > 0) {
+        CorridorHeapEntry entry = popCorridorHeap(search, &heapSize);
+        uint32_t node = entry.node;
+        if (entry.distance > search->distances[node]) {
+            continue;
+        }
+        if (entry.distance >= route->distance) {
+            break;
+        }
+
+        for (int a = 0; a < route->endCount; a++) {
+            if (route->endAnchors[a].node == node && entry.distance + route->endAnchors[a].distance < route->distance) {
+                route->distance = entry.distance + route->endAnchors[a].distance;
+                route->directMove = -1;
+                route->lastNode = node;
+                route->endAnchor = a;
+            }
+        }
+
+        for (uint32_t edge = graph->offsets[node]; edge < graph->offsets[node + 1]; edge++) {
+            if (!relaxCorridorNode(search, &heapSize, graph->targets[edge], entry.distance + graph->weights[edge],
+                                   node, edge)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * 从格子出发先走 move，沿走廊写出 steps 步命令
+ */
+static void writeCorridorSteps(const Maze *maze, CellIndex cell, int move, uint32_t steps, char *dest) {
+    for (uint32_t i = 0; i < steps; i++) {
+        dest[i] = directionToCommand((Direction)move);
+        cell += maze->moveOffsets[move];
+        if (i + 1 < steps) {
+            move = nextCorridorMove(maze, cell, move);
+        }
+    }
+}
+
+/**
+ * 从格子出发先走 move 沿走廊走 steps 步，把反方向的命令从 destEnd 往前写，
+ * 得到从走廊另一端走回该格子的命令
+ */
+static void writeCorridorStepsReversed(const Maze *maze, CellIndex cell, int move, uint32_t steps, char *destEnd) {
+    for (uint32_t i = 0; i < steps; i++) {
+        destEnd[-1 - (ptrdiff_t)i] = directionToCommand((Direction)(move ^ 1));
+        cell += maze->moveOffsets[move];
+        if (i + 1 < steps) {
+            move = nextCorridorMove(maze, cell, move);
+        }
+    }
+}
+
+/**
+ * 在走廊图上求两点间最短路径长度
+ *
+ * @param graph 走廊图
+ * @param search 可复用的搜索工作区
+ * @param start 起点，任意可通行格子
+ * @param end 终点，任意可通行格子
+ * @return 最短路径长度，不可达、位置无效或内存不足时返回-1
+ */
+int corridorShortestDistance(const CorridorGraph *graph, CorridorSearch *search, Position start, Position end) {
+    CorridorRoute route;
+    if (!routeCorridor(graph, search, start, end, &route) || route.distance == CORRIDOR_INFINITY) {
+        return -1;
+    }
+    return (int)route.distance;
+}
+
+/**
+ * 在走廊图上寻找最短路径并展开成逐格的移动命令
+ *
+ * 依次写出起点走到第一个节点、图中经过的各条走廊、最后一个节点走到终点的命令。
+ * 如果缓冲区不够，path->length 仍会给出所需步数。
+ *
+ * @param graph 走廊图
+ * @param search 可复用的搜索工作区
+ * @param start 起点
+ * @param end 终点
+ * @param path 接收结果的路径，命令缓冲区由调用者提供
+ * @return 找到路径并写入缓冲区返回true，否则返回false
+ */
+bool findShortestPathCorridor(const CorridorGraph *graph, CorridorSearch *search, Position start, Position end, MazePath *path) {
+    const Maze *maze = graph->maze;
+    CorridorRoute route;
+    path->start = start;
+    path->length = -1;
+    if (!routeCorridor(graph, search, start, end, &route) || route.distance == CORRIDOR_INFINITY) {
+        return false;
+    }
+    path->length = (int)route.distance;
+    if (path->length > path->capacity) {
+        return false;
+    }
+
+    CellIndex startCell = MAZE_INDEX(maze, start.row, start.col);
+    if (route.distance == 0 || route.directMove >= 0) {
+        writeCorridorSteps(maze, startCell, route.directMove, route.distance, path->commands);
+        return true;
+    }
+
+    // 最后一个节点到终点的一段写在末尾
+    const CorridorAnchor *last = &route.endAnchors[route.endAnchor];
+    CellIndex endCell = MAZE_INDEX(maze, end.row, end.col);
+    size_t cursor = route.distance;
+    if (last->distance > 0) {
+        writeCorridorStepsReversed(maze, endCell, last->move, last->distance, path->commands + cursor);
+        cursor -= last->distance;
+    }
+
+    // 沿来边从后往前写出图中经过的各条走廊
+    uint32_t node = route.lastNode;
+    while (search->edges[node] != CORRIDOR_NO_EDGE) {
+        uint32_t edge = search->edges[node];
+        uint32_t from = search->previous[node];
+        cursor -= graph->weights[edge];
+        writeCorridorSteps(maze, graph->nodeCells[from], graph->moves[edge], graph->weights[edge],
+                           path->commands + cursor);
+        node = from;
+    }
+
+    // 起点到第一个节点的一段，两个入口到同一节点时取较近的一个
+    const CorridorAnchor *first = NULL;
+    for (int a = 0; a < route.startCount; a++) {
+        if (route.startAnchors[a].node == node &&
+            (!first || route.startAnchors[a].distance < first->distance)) {
+            first = &route.startAnchors[a];
+        }
+    }
+    if (first && first->distance > 0) {
+        writeCorridorSteps(maze, startCell, first->move, first->distance, path->commands);
+    }
+    return true;
+}
+
+/**
+ * 建立走廊图计算从起点到终点的最短路径长度
+ *
+ * @param maze 指向迷宫结构体的指针
+ * @return 最短路径长度，如果不可达或内存不足则返回-1
+ */
+int calculateShortestPathLengthCorridor(Maze *maze) {
+    CorridorGraph graph;
+    if (!buildCorridorGraph(&graph, maze)) {
+        return -1;
+    }
+    CorridorSearch search;
+    initCorridorSearch(&search);
+
+    int length = corridorShortestDistance(&graph, &search, maze->start, maze->exit);
+
+    freeCorridorSearch(&search);
+    freeCorridorGraph(&graph);
+    return length;
+}
@@ -0,0 +1,67 @@
+#ifndef CORRIDOR_GRAPH_H
+#define CORRIDOR_GRAPH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "maze.h"
+#include "path_finder.h"
+
+// 走廊图：岔路口、死胡同、起点和终点作为节点，两节点间的走廊压缩成一条带长度的边
+// 邻接表按 CSR 格式存放，节点 i 的边为 [offsets[i], offsets[i + 1])
+typedef struct {
+    const Maze* maze;       // 所属迷宫，建图后不能修改
+    uint32_t* nodeIds;      // 每格的节点编号加一，0 表示不是节点，与 cells 一一对应
+    size_t cellCount;       // nodeIds 的格子数
+    CellIndex* nodeCells;   // 各节点所在格子的下标
+    uint32_t nodeCount;     // 节点数
+    uint32_t* offsets;      // 各节点第一条边的位置，共 nodeCount + 1 项
+    uint32_t* targets;      // 边的另一端节点
+    uint32_t* weights;      // 边的长度（步数）
+    uint8_t* moves;         // 从本节点走上这条边的第一步方向，展开路径时使用
+    uint32_t edgeCount;     // 边数，每条走廊两个方向各算一条
+} CorridorGraph;
+
+// 优先队列中的条目
+typedef struct {
+    uint32_t distance;      // 到该节点的距离
+    uint32_t node;          // 节点编号
+} CorridorHeapEntry;
+
+// 走廊图搜索的工作区，由调用者持有并在多次查询间复用，多个线程可以各用各的工作区共享同一张图
+typedef struct {
+    uint32_t* distances;    // 各节点的当前距离
+    uint32_t* stamps;       // 各节点最近一次被访问的搜索编号
+    uint32_t* previous;     // 到达各节点时的上一个节点
+    uint32_t* edges;        // 到达各节点时走的边，起点附近的节点为 CORRIDOR_NO_EDGE
+    size_t capacity;        // 已分配的节点数
+    uint32_t stamp;         // 当前搜索编号，用于免清零地判断是否访问过
+    CorridorHeapEntry* heap;    // 二叉堆，按需倍增并在多次查询间保留
+    size_t heapCapacity;    // 二叉堆已分配的条目数
+} CorridorSearch;
+
+// 从起点直接进入图时节点的来边
+#define CORRIDOR_NO_EDGE UINT32_MAX
+
+// 把迷宫的走廊压缩成加权图
+bool buildCorridorGraph(CorridorGraph *graph, const Maze *maze);
+
+// 释放走廊图
+void freeCorridorGraph(CorridorGraph *graph);
+
+// 初始化走廊图搜索工作区
+void initCorridorSearch(CorridorSearch *search);
+
+// 释放走廊图搜索工作区
+void freeCorridorSearch(CorridorSearch *search);
+
+// 在走廊图上求两点间最短路径长度，两点可以是任意可通行格子
+int corridorShortestDistance(const CorridorGraph *graph, CorridorSearch *search, Position start, Position end);
+
+// 在走廊图上寻找最短路径并展开成逐格的移动命令
+bool findShortestPathCorridor(const CorridorGraph *graph, CorridorSearch *search, Position start, Position end, MazePath *path);
+
+// 建立走廊图计算从起点到终点的最短路径长度
+int calculateShortestPathLengthCorridor(Maze *maze);
+
+#endif /* CORRIDOR_GRAPH_H */
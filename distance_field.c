@@ -0,0 +1,94 @@
+#include "distance_field.h"
+#include "large_buffer.h"
+
+/**
+ * 从终点反向BFS，为每个格子记录到终点的步数
+ *
+ * 迷宫中的移动是双向的，从终点出发一次BFS即可得到所有格子到终点的距离。
+ * 结果保存在 maze->exitDistances 中，与 cells 一一对应，存放步数加一，
+ * 0 表示到不了终点（含墙和哨兵），因此缓冲区无需额外初始化。
+ * 已计算过时直接返回。
+ *
+ * @param maze 指向迷宫结构体的指针
+ * @return 成功返回true，内存不足返回false
+ */
+bool buildExitDistances(Maze *maze) {
+    if (maze->exitDistances) {
+        return true;
+    }
+
+    size_t cellCount = MAZE_CELL_COUNT(maze);
+    uint32_t *distances = (uint32_t*)allocateBuffer(cellCount * sizeof(uint32_t));
+    CellIndex *queue = (CellIndex*)allocateBuffer(cellCount * sizeof(CellIndex));
+    if (!distances || !queue) {
+        releaseBuffer(distances, cellCount * sizeof(uint32_t));
+        releaseBuffer(queue, cellCount * sizeof(CellIndex));
+        return false;
+    }
+
+    const uint8_t *masks = maze->moveMasks;
+    size_t head = 0;
+    size_t tail = 0;
+    CellIndex exit = MAZE_INDEX(maze, maze->exit.row, maze->exit.col);
+    distances[exit] = 1;
+    queue[tail++] = exit;
+
+    while (head < tail) {
+        CellIndex index = queue[head++];
+        uint32_t next = distances[index] + 1;
+        // 只遍历可移动方向掩码中置位的方向
+        for (unsigned mask = masks[index]; mask; mask &= mask - 1) {
+            CellIndex neighbor = index + maze->moveOffsets[__builtin_ctz(mask)];
+            if (distances[neighbor] == 0) {
+                distances[neighbor] = next;
+                queue[tail++] = neighbor;
+            }
+        }
+    }
+
+    releaseBuffer(queue, cellCount * sizeof(CellIndex));
+    maze->exitDistances = distances;
+    return true;
+}
+
+/**
+ * 查表得到从指定位置到终点的步数
+ *
+ * @param maze 指向迷宫结构体的指针，需先调用 buildExitDistances
+ * @param pos 位置
+ * @return 到终点的步数，不可达、越界或未计算时返回-1
+ */
+int distanceToExit(const Maze *maze, Position pos) {
+    if (!maze->exitDistances || pos.row < 0 || pos.row >= maze->height ||
+        pos.col < 0 || pos.col >= maze->width) {
+        return -1;
+    }
+    return (int)maze->exitDistances[MAZE_INDEX(maze, pos.row, pos.col)] - 1;
+}
+
+/**
+ * 查表得到从指定位置走向终点的下一步方向
+ *
+ * 选择距离比当前格子少一的相邻格子，多条最短路径时按 Direction 的顺序取第一条。
+ *
+ * @param maze 指向迷宫结构体的指针，需先调用 buildExitDistances
+ * @param pos 当前位置
+ * @param dir 输出下一步的方向
+ * @return 找到返回true，已在终点、不可达或未计算时返回false
+ */
+bool nextHintMove(const Maze *maze, Position pos, Direction *dir) {
+    int remaining = distanceToExit(maze, pos);
+    if (remaining <= 0) {
+        return false;
+    }
+
+    CellIndex index = MAZE_INDEX(maze, pos.row, pos.col);
+    for (unsigned mask = maze->moveMasks[index]; mask; mask &= mask - 1) {
+        int d = __builtin_ctz(mask);
+        if (maze->exitDistances[index + maze->moveOffsets[d]] == (uint32_t)remaining) {
+            *dir = (Direction)d;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,16 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include <stdbool.h>
+#include "maze.h"
+
+// 从终点反向BFS，为每个格子记录到终点的步数
+bool buildExitDistances(Maze *maze);
+
+// 查表得到从指定位置到终点的步数，不可达或未计算时返回-1
+int distanceToExit(const Maze *maze, Position pos);
+
+// 查表得到从指定位置走向终点的下一步方向
+bool nextHintMove(const Maze *maze, Position pos, Direction *dir);
+
+#endif /* DISTANCE_FIELD_H */
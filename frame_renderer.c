@@ -0,0 +1,224 @@
+#include "frame_renderer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+// 差量更新最多输出的字节数：两个格子各为上移、定列、字符、回行首、下移
+#define DIFF_UPDATE_SIZE 96
+
+/**
+ * 初始化帧渲染器
+ *
+ * @param renderer 指向帧渲染器的指针
+ * @param mode 输出方式
+ * @param fd 输出的文件描述符
+ */
+void initFrameRenderer(FrameRenderer *renderer, FrameMode mode, int fd) {
+    renderer->buffer = NULL;
+    renderer->capacity = 0;
+    renderer->mode = mode;
+    renderer->fd = fd;
+    resetFrameRenderer(renderer);
+}
+
+/**
+ * 让下一帧重新完整输出
+ *
+ * 差量更新以光标停在上一帧正下方的行首为前提，两帧之间输出过提示等其他内容后必须调用。
+ *
+ * @param renderer 指向帧渲染器的指针
+ */
+void resetFrameRenderer(FrameRenderer *renderer) {
+    renderer->maze = NULL;
+    renderer->width = 0;
+    renderer->height = 0;
+    renderer->player.row = -1;
+    renderer->player.col = -1;
+    renderer->drawn = false;
+}
+
+/**
+ * 释放帧渲染器
+ *
+ * @param renderer 指向帧渲染器的指针
+ */
+void freeFrameRenderer(FrameRenderer *renderer) {
+    free(renderer->buffer);
+    renderer->buffer = NULL;
+    renderer->capacity = 0;
+    resetFrameRenderer(renderer);
+}
+
+/**
+ * 把缓冲区完整写出，处理部分写入和信号中断
+ *
+ * 写出前先刷新 stdout，保证与之前的 printf 输出顺序一致。
+ */
+static bool writeAll(int fd, const char *data, size_t size) {
+    fflush(stdout);
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+/**
+ * 完整一帧的字节数，每行末尾带换行符
+ *
+ * @param maze 指向迷宫结构体的指针
+ * @return 帧的字节数
+ */
+size_t mazeFrameSize(const Maze *maze) {
+    return ((size_t)maze->width + 1) * maze->height;
+}
+
+/**
+ * 把迷宫拼成完整一帧写入调用者提供的缓冲区
+ *
+ * 每行整段复制后补上换行符，玩家字符只在一个位置覆盖。
+ *
+ * @param dest 目标缓冲区，至少 mazeFrameSize 字节
+ * @param maze 指向迷宫结构体的指针
+ * @param player 玩家位置
+ */
+void writeMazeFrame(char *dest, const Maze *maze, Position player) {
+    size_t lineSize = (size_t)maze->width + 1;
+
+    // 行跨度正好是宽度加一时（映射加载的文件）整个网格一次复制
+    if (maze->stride == maze->width + 1) {
+        memcpy(dest, maze->grid, lineSize * maze->height - 1);
+    } else {
+        for (int i = 0; i < maze->height; i++) {
+            memcpy(dest + lineSize * i, &MAZE_CELL(maze, i, 0), (size_t)maze->width);
+        }
+    }
+    for (int i = 0; i < maze->height; i++) {
+        dest[lineSize * i + maze->width] = '\n';
+    }
+
+    dest[lineSize * player.row + player.col] = PLAYER_CHAR;
+}
+
+/**
+ * 在渲染器的缓冲区中拼好一帧，返回总字节数，内存不足时返回0
+ */
+static size_t composeFrame(FrameRenderer *renderer, const Maze *maze, Position player) {
+    size_t frameSize = mazeFrameSize(maze);
+    if (frameSize > renderer->capacity) {
+        char *buffer = (char*)realloc(renderer->buffer, frameSize);
+        if (!buffer) {
+            return 0;
+        }
+        renderer->buffer = buffer;
+        renderer->capacity = frameSize;
+    }
+
+    writeMazeFrame(renderer->buffer, maze, player);
+    return frameSize;
+}
+
+/**
+ * 终端窗口能否完整容纳一帧和其下方的光标行，相对光标移动才能到达帧的每一行
+ */
+static bool frameFitsTerminal(int fd, const Maze *maze) {
+    struct winsize window;
+    if (!isatty(fd) || ioctl(fd, TIOCGWINSZ, &window) != 0) {
+        return false;
+    }
+    return maze->height < window.ws_row && maze->width <= window.ws_col;
+}
+
+/**
+ * 追加一个格子的差量更新：从帧下方的行首上移到格子所在行，定位到列后写出字符，再回到原处
+ *
+ * 只用相对的行移动和行内的列定位，帧随提示向上滚动后仍然正确。
+ */
+static int appendCellUpdate(char *update, size_t size, const Maze *maze, Position cell, char c) {
+    int rows = maze->height - cell.row;
+    // ANSI 列号从1开始
+    return snprintf(update, size, "\x1b[%dA\x1b[%dG%c\r\x1b[%dB", rows, cell.col + 1, c, rows);
+}
+
+/**
+ * 差量模式下只重画玩家离开和到达的两个格子
+ */
+static bool renderDiff(FrameRenderer *renderer, const Maze *maze, Position player) {
+    char update[DIFF_UPDATE_SIZE];
+    int size = 0;
+    Position from = renderer->player;
+
+    if (from.row != player.row || from.col != player.col) {
+        size += appendCellUpdate(update + size, sizeof(update) - size, maze, from,
+                                 MAZE_CELL(maze, from.row, from.col));
+        size += appendCellUpdate(update + size, sizeof(update) - size, maze, player, PLAYER_CHAR);
+    }
+    return writeAll(renderer->fd, update, (size_t)size);
+}
+
+/**
+ * 输出一帧，玩家位于迷宫记录的位置
+ *
+ * @param renderer 指向帧渲染器的指针
+ * @param maze 指向迷宫结构体的指针
+ * @return 输出结果
+ */
+FrameResult renderFrame(FrameRenderer *renderer, const Maze *maze) {
+    return renderFrameAt(renderer, maze, maze->player);
+}
+
+/**
+ * 输出一帧，玩家位于指定位置
+ *
+ * 完整模式每次拼好整帧后一次写出。差量模式在同一迷宫的上一帧之后、
+ * 没有调用过 resetFrameRenderer 时只重画变化的格子；首帧、迷宫或尺寸变化、
+ * 输出不是终端或窗口放不下整帧、以及上一次写出失败之后都输出完整一帧。
+ * 迷宫本身只读，多个会话可以共用同一个迷宫。
+ *
+ * @param renderer 指向帧渲染器的指针
+ * @param maze 指向迷宫结构体的指针
+ * @param player 玩家位置
+ * @return 输出结果，内存不足时什么也没有写出，写出失败时可能已写出一部分
+ */
+FrameResult renderFrameAt(FrameRenderer *renderer, const Maze *maze, Position player) {
+    if (renderer->mode == FRAME_DIFF && renderer->drawn && renderer->maze == maze &&
+        renderer->width == maze->width && renderer->height == maze->height &&
+        frameFitsTerminal(renderer->fd, maze)) {
+        if (!renderDiff(renderer, maze, player)) {
+            // 部分写出后光标位置未知
+            resetFrameRenderer(renderer);
+            return FRAME_WRITE_FAILED;
+        }
+        renderer->player = player;
+        return FRAME_WRITTEN;
+    }
+
+    resetFrameRenderer(renderer);
+    size_t frameSize = composeFrame(renderer, maze, player);
+    if (frameSize == 0) {
+        return FRAME_OUT_OF_MEMORY;
+    }
+    if (!writeAll(renderer->fd, renderer->buffer, frameSize)) {
+        return FRAME_WRITE_FAILED;
+    }
+
+    // 整帧以换行结束，光标停在帧正下方的行首
+    if (renderer->mode == FRAME_DIFF) {
+        renderer->maze = maze;
+        renderer->width = maze->width;
+        renderer->height = maze->height;
+        renderer->player = player;
+        renderer->drawn = true;
+    }
+    return FRAME_WRITTEN;
+}
@@ -0,0 +1,55 @@
+#ifndef FRAME_RENDERER_H
+#define FRAME_RENDERER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "maze.h"
+
+// 输出一帧的结果
+typedef enum {
+    FRAME_WRITTEN,          // 整帧已写出
+    FRAME_OUT_OF_MEMORY,    // 帧缓冲区分配失败，什么也没有写出
+    FRAME_WRITE_FAILED      // 写出失败，可能已写出一部分
+} FrameResult;
+
+// 帧的输出方式
+typedef enum {
+    FRAME_FULL,     // 每次输出完整一帧
+    FRAME_DIFF      // 光标仍停在上一帧正下方时，用相对光标移动只重画玩家离开和到达的格子
+} FrameMode;
+
+// 帧渲染器，整帧在一块可复用的缓冲区中拼好后一次写出
+typedef struct {
+    char* buffer;           // 帧缓冲区
+    size_t capacity;        // 帧缓冲区大小
+    FrameMode mode;         // 输出方式
+    int fd;                 // 输出的文件描述符
+    const Maze* maze;       // 差量模式下上一帧画出的迷宫
+    int width;              // 上一帧的迷宫宽度
+    int height;             // 上一帧的迷宫高度
+    Position player;        // 上一帧的玩家位置
+    bool drawn;             // 差量模式下光标是否仍停在上一帧正下方的行首
+} FrameRenderer;
+
+// 完整一帧的字节数
+size_t mazeFrameSize(const Maze *maze);
+
+// 把迷宫拼成完整一帧写入调用者提供的缓冲区
+void writeMazeFrame(char *dest, const Maze *maze, Position player);
+
+// 初始化帧渲染器
+void initFrameRenderer(FrameRenderer *renderer, FrameMode mode, int fd);
+
+// 输出一帧，玩家位于迷宫记录的位置
+FrameResult renderFrame(FrameRenderer *renderer, const Maze *maze);
+
+// 输出一帧，玩家位于指定位置
+FrameResult renderFrameAt(FrameRenderer *renderer, const Maze *maze, Position player);
+
+// 让下一帧重新完整输出，两帧之间有其他输出时调用
+void resetFrameRenderer(FrameRenderer *renderer);
+
+// 释放帧渲染器
+void freeFrameRenderer(FrameRenderer *renderer);
+
+#endif /* FRAME_RENDERER_H */
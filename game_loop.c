@@ -1,8 +1,11 @@
 #include "game_loop.h"
 #include "maze_operations.h"
+#include "path_finder.h"
+#include "input_reader.h"
+#include "distance_field.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <ctype.h>
+#include <unistd.h>
 
 /**
  * 显示游戏说明
@@ -15,6 +18,7 @@ void displayGameInstructions() {
     printf("  a: 向左移动\n");
     printf("  d: 向右移动\n");
     printf("  m: 显示地图\n");
+    printf("  h: 提示下一步\n");
     printf("  q: 退出游戏\n\n");
 }
 
@@ -36,71 +40,116 @@ void handleWallCollision() {
  * 处理无效命令
  */
 void handleInvalidCommand() {
-    printf("无效的命令，请输入 w/s/a/d/m/q\n");
+    printf("无效的命令，请输入 w/s/a/d/m/h/q\n");
+}
+
+/**
+ * 显示提示：下一步的方向和到终点还需的步数
+ * 
+ * 距离表未能分配时只说明提示不可用。
+ * 
+ * @param session 指向游戏会话的指针
+ */
+void handleHint(const GameSession *session) {
+    static const char *const DIRECTION_NAMES[] = {"上", "下", "左", "右"};
+    if (!session->maze->exitDistances) {
+        printf("提示不可用：距离表未能分配\n");
+        return;
+    }
+    Direction dir;
+    if (!nextHintMove(session->maze, session->player, &dir)) {
+        printf("提示：从这里无法到达终点\n");
+        return;
+    }
+    printf("提示：向%s走（%c），距终点还有 %d 步\n", DIRECTION_NAMES[dir], directionToCommand(dir),
+           distanceToExit(session->maze, session->player));
 }
 
 /**
  * 处理用户输入
  * 
- * @param maze 指向迷宫结构体的指针
+ * 命令交给会话处理，这里只根据结果输出提示。
+ * 
+ * @param session 指向游戏会话的指针
  * @param input 用户输入
+ * @return 处理结果
  */
-void handleInput(Maze *maze, char input) {
-    input = tolower(input);
-    bool moved = false;
-
-    switch (input) {
-        case 'w':
-            moved = movePlayer(maze, UP);
+StepResult handleInput(GameSession *session, char input) {
+    StepResult result = stepGameSession(session, input);
+    
+    switch (result) {
+        case STEP_SHOW_MAP:
+            displayMazeAt(session->maze, session->player);
             break;
-        case 's':
-            moved = movePlayer(maze, DOWN);
+        case STEP_HINT:
+            handleHint(session);
             break;
-        case 'a':
-            moved = movePlayer(maze, LEFT);
+        case STEP_BLOCKED:
+            handleWallCollision();
             break;
-        case 'd':
-            moved = movePlayer(maze, RIGHT);
+        case STEP_INVALID:
+            handleInvalidCommand();
             break;
-        case 'm':
-            displayMaze(maze);
-            return;
-        case 'q':
+        case STEP_QUIT:
             printf("游戏已退出\n");
-            exit(0);
+            break;
+        case STEP_WON:
+            handleGameWin();
+            break;
         default:
-            handleInvalidCommand();
-            return;
-    }
-
-    if (!moved) {
-        handleWallCollision();
+            break;
     }
+    
+    return result;
 }
 
 /**
  * 游戏主循环
  * 
+ * 每次唤醒时读入所有已到达的输入并依次处理，处理完才提示并等待下一批输入。
+ * 终端输入为原始模式，按键无需回车；文件或管道输入整块读取，读完即结束。
+ * 
  * @param maze 指向迷宫结构体的指针
+ * @return 游戏结束时的会话状态，输入结束时仍为 GAME_RUNNING
  */
-void gameLoop(Maze *maze) {
+GameState gameLoop(Maze *maze) {
+    InputReader *reader = (InputReader*)malloc(sizeof(InputReader));
+    if (!reader) {
+        printf("错误：内存分配失败\n");
+        return GAME_RUNNING;
+    }
+    
+    // 到终点的距离表只算一次，之后每次提示都是查表；内存不足时不提供提示，游戏照常进行
+    if (!buildExitDistances(maze)) {
+        printf("警告：内存不足，本局无法使用提示\n");
+    }
+    
+    GameSession session;
+    initGameSession(&session, maze);
+    
     // 显示游戏说明
     displayGameInstructions();
     
     // 显示初始迷宫
-    displayMaze(maze);
-
-    while (1) {
-        // 检查是否到达终点
-        if (isSamePosition(maze->player, maze->exit)) {
-            handleGameWin();
-            break;
-        }
-
-        // 获取用户输入
-        printf("请输入移动方向 (w/s/a/d/m/q): ");
+    displayMazeAt(maze, session.player);
+    
+    openInputReader(reader, STDIN_FILENO);
+    while (!isGameOver(&session)) {
+        // 已到达的输入处理完后再提示并等待
         char input;
-        scanf(" %c", &input);
-        handleInput(maze, input);
+        if (!nextInputCommand(reader, &input)) {
+            printf("请输入移动方向 (w/s/a/d/m/h/q): ");
+            fflush(stdout);
+            if (!fillInputReader(reader, -1) && reader->eof) {
+                printf("\n");
+                break;
+            }
+            continue;
+        }
+        handleInput(&session, input);
     }
-} 
\ No newline at end of file
+    
+    closeInputReader(reader);
+    free(reader);
+    return session.state;
+}
@@ -2,12 +2,13 @@
 #define GAME_LOOP_H
 
 #include "maze.h"
+#include "game_session.h"
 
-// 处理用户输入
-void handleInput(Maze *maze, char input);
+// 处理用户输入，返回本条命令的处理结果
+StepResult handleInput(GameSession *session, char input);
 
-// 游戏主循环
-void gameLoop(Maze *maze);
+// 游戏主循环，返回游戏结束时的会话状态
+GameState gameLoop(Maze *maze);
 
 // 显示游戏说明
 void displayGameInstructions();
@@ -21,4 +22,7 @@ void handleWallCollision();
 // 处理无效命令
 void handleInvalidCommand();
 
+// 显示提示：下一步的方向和到终点还需的步数
+void handleHint(const GameSession *session);
+
 #endif /* GAME_LOOP_H */ 
\ No newline at end of file
@@ -0,0 +1,480 @@
+#define _GNU_SOURCE
+#include "game_server.h"
+#include "game_session.h"
+#include "frame_renderer.h"
+#include "input_validator.h"
+#include "distance_field.h"
+#include "path_finder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// 每个结果行的最大长度
+#define RESPONSE_LINE_SIZE 48
+
+// 一个客户端连接
+typedef struct ServerConnection {
+    int fd;                 // 连接的套接字
+    GameSession session;    // 该连接的游戏会话
+    char* output;           // 待发送的数据
+    size_t outputStart;     // 下一个待发送的字节
+    size_t outputEnd;       // 已写入的字节数
+    size_t outputCapacity;  // 发送缓冲区大小
+    char input[SERVER_READ_SIZE];   // 已读入但因发送缓冲区已满尚未处理的命令
+    size_t inputStart;      // 下一个未处理的命令字节
+    size_t inputEnd;        // 已读入的字节数
+    bool closing;           // 会话已结束，发送完毕后关闭
+    bool reading;           // 是否在监听可读事件
+    struct ServerConnection* prev;  // 连接链表，服务器退出时据此关闭所有连接
+    struct ServerConnection* next;
+} ServerConnection;
+
+// 收到 SIGINT 或 SIGTERM 后置位，事件循环随即退出
+static volatile sig_atomic_t stopRequested = 0;
+
+/**
+ * 停止信号处理函数
+ */
+static void requestStop(int signal) {
+    (void)signal;
+    stopRequested = 1;
+}
+
+/**
+ * 各处理结果在协议中的名称，顺序与 StepResult 一致
+ */
+static const char *const STEP_NAMES[] = {
+    "moved", "blocked", "won", "map", "hint", "quit", "invalid", "finished"
+};
+
+/**
+ * 确保发送缓冲区还能追加 extra 字节
+ */
+static bool reserveOutput(ServerConnection *connection, size_t extra) {
+    // 已发送的部分移到前面复用
+    if (connection->outputStart > 0) {
+        memmove(connection->output, connection->output + connection->outputStart,
+                connection->outputEnd - connection->outputStart);
+        connection->outputEnd -= connection->outputStart;
+        connection->outputStart = 0;
+    }
+    if (connection->outputEnd + extra <= connection->outputCapacity) {
+        return true;
+    }
+
+    size_t capacity = connection->outputCapacity ? connection->outputCapacity : SERVER_READ_SIZE;
+    while (capacity < connection->outputEnd + extra) {
+        capacity *= 2;
+    }
+    char *output = (char*)realloc(connection->output, capacity);
+    if (!output) {
+        return false;
+    }
+    connection->output = output;
+    connection->outputCapacity = capacity;
+    return true;
+}
+
+/**
+ * 追加一行结果：“名称 行 列”
+ */
+static bool appendResponse(ServerConnection *connection, StepResult result) {
+    if (!reserveOutput(connection, RESPONSE_LINE_SIZE)) {
+        return false;
+    }
+    Position player = connection->session.player;
+    int size = snprintf(connection->output + connection->outputEnd, RESPONSE_LINE_SIZE, "%s %d %d\n",
+                        STEP_NAMES[result], player.row, player.col);
+    connection->outputEnd += (size_t)size;
+    return true;
+}
+
+/**
+ * 追加当前地图，之后是一行 map 结果
+ */
+static bool appendMap(ServerConnection *connection) {
+    const Maze *maze = connection->session.maze;
+    size_t frameSize = mazeFrameSize(maze);
+    if (!reserveOutput(connection, frameSize)) {
+        return false;
+    }
+    writeMazeFrame(connection->output + connection->outputEnd, maze, connection->session.player);
+    connection->outputEnd += frameSize;
+    return appendResponse(connection, STEP_SHOW_MAP);
+}
+
+/**
+ * 追加提示行“next 命令 剩余步数”，之后是一行 hint 结果；
+ * 无法到达终点时命令为 -，剩余步数为-1
+ */
+static bool appendHint(ServerConnection *connection) {
+    if (!reserveOutput(connection, RESPONSE_LINE_SIZE)) {
+        return false;
+    }
+    const GameSession *session = &connection->session;
+    Direction dir;
+    char command = nextHintMove(session->maze, session->player, &dir) ? directionToCommand(dir) : '-';
+    int size = snprintf(connection->output + connection->outputEnd, RESPONSE_LINE_SIZE, "next %c %d\n",
+                        command, distanceToExit(session->maze, session->player));
+    connection->outputEnd += (size_t)size;
+    return appendResponse(connection, STEP_HINT);
+}
+
+/**
+ * 把发送缓冲区尽量写出，对端暂时无法接收时留待可写事件
+ *
+ * @return 连接仍然可用返回true，出错返回false
+ */
+static bool flushOutput(ServerConnection *connection) {
+    while (connection->outputStart < connection->outputEnd) {
+        ssize_t sent = send(connection->fd, connection->output + connection->outputStart,
+                            connection->outputEnd - connection->outputStart, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        connection->outputStart += (size_t)sent;
+    }
+    connection->outputStart = 0;
+    connection->outputEnd = 0;
+    return true;
+}
+
+/**
+ * 根据连接状态更新 epoll 监听的事件
+ */
+static void updateInterest(int epollFd, ServerConnection *connection) {
+    bool pending = connection->outputStart < connection->outputEnd;
+    connection->reading = !connection->closing && connection->outputEnd - connection->outputStart < SERVER_OUTPUT_LIMIT;
+
+    struct epoll_event event;
+    event.events = (connection->reading ? EPOLLIN : 0) | (pending ? EPOLLOUT : 0);
+    event.data.ptr = connection;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+}
+
+/**
+ * 关闭连接并释放其资源
+ */
+static void closeConnection(int epollFd, ServerConnection **connections, ServerConnection *connection) {
+    if (connection->prev) {
+        connection->prev->next = connection->next;
+    } else {
+        *connections = connection->next;
+    }
+    if (connection->next) {
+        connection->next->prev = connection->prev;
+    }
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    free(connection->output);
+    free(connection);
+}
+
+/**
+ * 接受所有等待中的连接，每个连接开始一个新的会话并发送迷宫信息
+ */
+static void acceptConnections(int epollFd, int listenFd, const Maze *maze, ServerConnection **connections) {
+    for (;;) {
+        int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        ServerConnection *connection = (ServerConnection*)calloc(1, sizeof(ServerConnection));
+        if (!connection) {
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->reading = true;
+        initGameSession(&connection->session, maze);
+
+        // 问候行：迷宫宽高和玩家起始位置
+        char greeting[RESPONSE_LINE_SIZE];
+        int size = snprintf(greeting, sizeof(greeting), "maze %d %d %d %d\n",
+                            maze->width, maze->height, connection->session.player.row,
+                            connection->session.player.col);
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        if (!reserveOutput(connection, (size_t)size) ||
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            free(connection->output);
+            free(connection);
+            continue;
+        }
+        memcpy(connection->output, greeting, (size_t)size);
+        connection->outputEnd = (size_t)size;
+
+        connection->next = *connections;
+        if (*connections) {
+            (*connections)->prev = connection;
+        }
+        *connections = connection;
+
+        if (!flushOutput(connection)) {
+            closeConnection(epollFd, connections, connection);
+            continue;
+        }
+        updateInterest(epollFd, connection);
+    }
+}
+
+/**
+ * 待发送的数据是否已达到上限
+ */
+static bool isOutputFull(const ServerConnection *connection) {
+    return connection->outputEnd - connection->outputStart >= SERVER_OUTPUT_LIMIT;
+}
+
+/**
+ * 是否还有已读入但未处理的命令
+ */
+static bool hasPendingCommands(const ServerConnection *connection) {
+    return connection->inputStart < connection->inputEnd;
+}
+
+/**
+ * 逐条处理已读入的命令，待发送的数据达到上限或会话结束时停下，其余命令留到之后处理
+ *
+ * 每条命令最多追加一帧地图，因此发送缓冲区不会超过上限加一帧。
+ *
+ * @return 连接仍然可用返回true，内存不足返回false
+ */
+static bool processCommands(ServerConnection *connection) {
+    while (hasPendingCommands(connection) && !connection->closing && !isOutputFull(connection)) {
+        char command = connection->input[connection->inputStart++];
+        if (isspace((unsigned char)command)) {
+            continue;
+        }
+        StepResult result = stepGameSession(&connection->session, command);
+        bool ok;
+        if (result == STEP_SHOW_MAP) {
+            ok = appendMap(connection);
+        } else if (result == STEP_HINT) {
+            ok = appendHint(connection);
+        } else {
+            ok = appendResponse(connection, result);
+        }
+        if (!ok) {
+            return false;
+        }
+        connection->closing = isGameOver(&connection->session);
+    }
+    return true;
+}
+
+/**
+ * 处理连接上已到达的命令
+ *
+ * 先处理上次留下的命令，处理完才继续读取。每条命令回复一行结果，m 先回复地图；
+ * 待发送的数据达到上限时停止读取，未读的命令留在套接字中，直到数据发送出去。
+ * 会话结束或对端不再发送后停止读取，剩余结果发送完毕即关闭。
+ *
+ * @return 连接仍然可用返回true，出错返回false
+ */
+static bool handleReadable(ServerConnection *connection) {
+    for (;;) {
+        if (!processCommands(connection)) {
+            return false;
+        }
+        if (connection->closing || isOutputFull(connection)) {
+            connection->reading = false;
+            return true;
+        }
+
+        ssize_t count = recv(connection->fd, connection->input, sizeof(connection->input), 0);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        if (count == 0) {
+            connection->closing = true;
+            connection->reading = false;
+            return true;
+        }
+        connection->inputStart = 0;
+        connection->inputEnd = (size_t)count;
+    }
+}
+
+/**
+ * 创建并监听 Unix 域套接字
+ */
+static int openListenSocket(const char *socketPath) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        printf("错误：套接字路径过长 %s\n", socketPath);
+        return -1;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        printf("错误：无法创建套接字\n");
+        return -1;
+    }
+
+    // 之前异常退出时可能留下同名的套接字文件
+    unlink(socketPath);
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        printf("错误：无法监听套接字 %s\n", socketPath);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * 在 Unix 域套接字上运行多会话游戏服务器
+ *
+ * 单线程 epoll 事件循环，每个连接一个游戏会话，所有会话共享同一个只读迷宫。
+ * 协议：连接后服务器先发送“maze 宽 高 行 列”；客户端发送 w/s/a/d/m/h/q 命令（空白忽略），
+ * 每条命令回复一行“结果 行 列”，结果为 moved/blocked/won/map/hint/quit/invalid，
+ * m 在结果行之前先发送地图，h 在结果行之前先发送“next 命令 剩余步数”。到达终点或退出后服务器发送完剩余数据即关闭连接。
+ * 收到 SIGINT 或 SIGTERM 时退出并删除套接字文件。
+ *
+ * @param socketPath 套接字路径
+ * @param maze 指向迷宫结构体的指针，服务器运行期间只读
+ * @return 正常退出返回true，无法启动返回false
+ */
+bool runGameServer(const char *socketPath, const Maze *maze) {
+    int listenFd = openListenSocket(socketPath);
+    if (listenFd < 0) {
+        return false;
+    }
+
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event listenEvent;
+    listenEvent.events = EPOLLIN;
+    listenEvent.data.ptr = NULL;
+    if (epollFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &listenEvent) != 0) {
+        printf("错误：无法创建事件循环\n");
+        if (epollFd >= 0) {
+            close(epollFd);
+        }
+        close(listenFd);
+        unlink(socketPath);
+        return false;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    stopRequested = 0;
+
+    ServerConnection *connections = NULL;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (!stopRequested) {
+        int count = epoll_wait(epollFd, events, SERVER_MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            ServerConnection *connection = (ServerConnection*)events[i].data.ptr;
+            if (!connection) {
+                acceptConnections(epollFd, listenFd, maze, &connections);
+                continue;
+            }
+
+            bool alive = !(events[i].events & EPOLLERR);
+            if (alive && (events[i].events & (EPOLLIN | EPOLLHUP))) {
+                alive = handleReadable(connection);
+            }
+            alive = alive && flushOutput(connection);
+
+            // 发送缓冲区腾出空间后继续处理留下的命令，它们已不在套接字中，不会再触发可读事件
+            while (alive && hasPendingCommands(connection) && !connection->closing && !isOutputFull(connection)) {
+                alive = handleReadable(connection) && flushOutput(connection);
+            }
+
+            if (!alive || (connection->closing && connection->outputStart == connection->outputEnd)) {
+                closeConnection(epollFd, &connections, connection);
+            } else {
+                updateInterest(epollFd, connection);
+            }
+        }
+    }
+
+    while (connections) {
+        closeConnection(epollFd, &connections, connections);
+    }
+    close(epollFd);
+    close(listenFd);
+    unlink(socketPath);
+    return true;
+}
+
+/**
+ * 检查命令行是否请求服务器模式
+ *
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数
+ * @return 第一个参数是服务器模式选项时返回true
+ */
+bool isServerCommandLine(int argc, char *argv[]) {
+    return argc >= 2 && strcmp(argv[1], SERVER_MODE_OPTION) == 0;
+}
+
+/**
+ * 运行服务器模式
+ *
+ * 用法：<程序> --serve <套接字路径> <迷宫文件> <宽度> <高度> [--large]
+ *
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数
+ * @return 正常退出返回0，否则返回1
+ */
+int runServerMode(int argc, char *argv[]) {
+    if (argc != 6 && argc != 7) {
+        printf("错误：命令行参数数量不正确\n");
+        printf("用法: %s %s <套接字路径> <迷宫文件> <宽度> <高度> [--large]\n", argv[0], SERVER_MODE_OPTION);
+        return 1;
+    }
+
+    // 迷宫参数与单文件模式相同，复用同一套验证
+    char *mazeArgs[] = {argv[0], argv[3], argv[4], argv[5], argc == 7 ? argv[6] : NULL};
+    if (!validateCommandLine(argc - 2, mazeArgs)) {
+        return 1;
+    }
+
+    // 迷宫只加载一次，所有会话共享；网格复制到自有内存，运行期间文件被改写也不受影响
+    Maze *maze = copyMazeFile(argv[3], atoi(argv[4]), atoi(argv[5]));
+    if (!maze) {
+        return 1;
+    }
+    // 到终点的距离表也只算一次，各会话的提示都是查表；内存不足时提示统一回复 "next - -1"
+    if (!buildExitDistances(maze)) {
+        printf("警告：内存不足，服务器不提供提示\n");
+    }
+
+    bool ok = runGameServer(argv[2], maze);
+    freeMaze(maze);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+#ifndef GAME_SERVER_H
+#define GAME_SERVER_H
+
+#include <stdbool.h>
+#include "maze.h"
+
+// 开启服务器模式的命令行选项
+#define SERVER_MODE_OPTION "--serve"
+
+// epoll 每次最多取出的事件数
+#define SERVER_MAX_EVENTS 256
+
+// 每次从连接读取的字节数
+#define SERVER_READ_SIZE 4096
+
+// 待发送数据超过该大小时暂停读取该连接，直到发送缓冲区排空
+#define SERVER_OUTPUT_LIMIT ((size_t)1 << 20)
+
+// 在 Unix 域套接字上运行多会话游戏服务器，所有会话共享同一个只读迷宫
+bool runGameServer(const char *socketPath, const Maze *maze);
+
+// 检查命令行是否请求服务器模式
+bool isServerCommandLine(int argc, char *argv[]);
+
+// 运行服务器模式，返回程序退出码
+int runServerMode(int argc, char *argv[]);
+
+#endif /* GAME_SERVER_H */
@@ -0,0 +1,85 @@
+#include "game_session.h"
+#include "maze_operations.h"
+#include "path_finder.h"
+#include <ctype.h>
+
+/**
+ * 初始化游戏会话
+ * 
+ * @param session 指向游戏会话的指针
+ * @param maze 指向迷宫结构体的指针，会话期间不能释放
+ */
+void initGameSession(GameSession *session, const Maze *maze) {
+    session->maze = maze;
+    session->player = maze->start;
+    session->state = isSamePosition(maze->start, maze->exit) ? GAME_WON : GAME_RUNNING;
+    session->steps = 0;
+    session->moves = 0;
+    session->collisions = 0;
+}
+
+/**
+ * 处理一条命令
+ * 
+ * 会话只在这里改变状态：到达终点进入 GAME_WON，q 进入 GAME_QUIT，
+ * 结束后的命令一律返回 STEP_FINISHED。不打印也不退出进程，
+ * 调用者根据返回值决定如何反馈，同一进程中可以同时运行任意多个会话。
+ * 
+ * @param session 指向游戏会话的指针
+ * @param command 命令字符，不区分大小写
+ * @return 处理结果
+ */
+StepResult stepGameSession(GameSession *session, char command) {
+    if (session->state != GAME_RUNNING) {
+        return STEP_FINISHED;
+    }
+    session->steps++;
+    
+    Direction dir;
+    switch (tolower((unsigned char)command)) {
+        case 'w':
+            dir = UP;
+            break;
+        case 's':
+            dir = DOWN;
+            break;
+        case 'a':
+            dir = LEFT;
+            break;
+        case 'd':
+            dir = RIGHT;
+            break;
+        case 'm':
+            return STEP_SHOW_MAP;
+        case 'h':
+            return STEP_HINT;
+        case 'q':
+            session->state = GAME_QUIT;
+            return STEP_QUIT;
+        default:
+            return STEP_INVALID;
+    }
+    
+    switch (movePosition(session->maze, &session->player, dir)) {
+        case MOVE_BLOCKED:
+            session->collisions++;
+            return STEP_BLOCKED;
+        case MOVE_REACHED_EXIT:
+            session->moves++;
+            session->state = GAME_WON;
+            return STEP_WON;
+        default:
+            session->moves++;
+            return STEP_MOVED;
+    }
+}
+
+/**
+ * 会话是否已结束
+ * 
+ * @param session 指向游戏会话的指针
+ * @return 已到达终点或已退出返回true
+ */
+bool isGameOver(const GameSession *session) {
+    return session->state != GAME_RUNNING;
+}
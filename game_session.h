@@ -0,0 +1,46 @@
+#ifndef GAME_SESSION_H
+#define GAME_SESSION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "maze.h"
+
+// 游戏会话状态
+typedef enum {
+    GAME_RUNNING,   // 进行中
+    GAME_WON,       // 已到达终点
+    GAME_QUIT       // 玩家已退出
+} GameState;
+
+// 处理一条命令的结果
+typedef enum {
+    STEP_MOVED,     // 移动成功
+    STEP_BLOCKED,   // 撞墙或超出边界
+    STEP_WON,       // 移动后到达终点，会话结束
+    STEP_SHOW_MAP,  // 请求显示地图
+    STEP_HINT,      // 请求提示下一步
+    STEP_QUIT,      // 退出，会话结束
+    STEP_INVALID,   // 无效命令
+    STEP_FINISHED   // 会话已结束，命令被忽略
+} StepResult;
+
+// 游戏会话，迷宫只读共享，玩家位置和状态由会话各自持有
+typedef struct {
+    const Maze* maze;   // 所在的迷宫
+    Position player;    // 玩家位置
+    GameState state;    // 会话状态
+    size_t steps;       // 已处理的命令数
+    size_t moves;       // 成功移动的次数
+    size_t collisions;  // 撞墙的次数
+} GameSession;
+
+// 初始化游戏会话，玩家从迷宫起点出发
+void initGameSession(GameSession *session, const Maze *maze);
+
+// 处理一条命令，不做任何输入输出
+StepResult stepGameSession(GameSession *session, char command);
+
+// 会话是否已结束
+bool isGameOver(const GameSession *session);
+
+#endif /* GAME_SESSION_H */
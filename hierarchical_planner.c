@@ -0,0 +1,842 @@
+#include "hierarchical_planner.h"
+#include "large_buffer.h"
+#include <pthread.h>
+#include <unistd.h>
+
+// 不可达的距离
+#define HPA_INFINITY UINT32_MAX
+
+// 各方向的行列偏移，顺序与 Direction 一致
+static const int HPA_ROW[4] = {-1, 1, 0, 0};
+static const int HPA_COL[4] = {0, 0, -1, 1};
+
+// 区块覆盖的矩形范围，最右一列和最下一行的区块可能不足边长
+typedef struct {
+    int row0;
+    int col0;
+    int rows;
+    int cols;
+} ClusterRect;
+
+// 预处理时各线程共享的进度
+typedef struct {
+    HierarchicalPlanner* planner;
+    uint32_t nextCluster;   // 下一个待处理的区块，原子递增
+    uint32_t completed;     // 已处理完的区块数，原子递增
+} PlannerBuild;
+
+/**
+ * 区块编号对应的矩形范围
+ */
+static ClusterRect clusterRect(const HierarchicalPlanner *planner, uint32_t cluster) {
+    const Maze *maze = planner->maze;
+    ClusterRect rect;
+    rect.row0 = (int)(cluster / planner->clusterCols) * planner->clusterSize;
+    rect.col0 = (int)(cluster % planner->clusterCols) * planner->clusterSize;
+    rect.rows = maze->height - rect.row0 < planner->clusterSize ? maze->height - rect.row0 : planner->clusterSize;
+    rect.cols = maze->width - rect.col0 < planner->clusterSize ? maze->width - rect.col0 : planner->clusterSize;
+    return rect;
+}
+
+/**
+ * 位置所在的区块编号
+ */
+static uint32_t clusterOf(const HierarchicalPlanner *planner, Position pos) {
+    return (uint32_t)(pos.row / planner->clusterSize) * planner->clusterCols + pos.col / planner->clusterSize;
+}
+
+/**
+ * 位置在区块内的格子编号
+ */
+static int localIndex(const HierarchicalPlanner *planner, const ClusterRect *rect, Position pos) {
+    return (pos.row - rect->row0) * planner->clusterSize + (pos.col - rect->col0);
+}
+
+/**
+ * 区块边界上按行优先顺序的下一个格子的列，中间各行只有首尾两列在边界上
+ */
+static int nextBorderCol(const ClusterRect *rect, int row, int col) {
+    if (row == 0 || row == rect->rows - 1 || col == rect->cols - 1) {
+        return col + 1;
+    }
+    return rect->cols - 1;
+}
+
+/**
+ * 区块边界格子是否与相邻区块的通路格子相通
+ */
+static bool isEntranceCell(const Maze *maze, const ClusterRect *rect, int row, int col) {
+    int r = rect->row0 + row;
+    int c = rect->col0 + col;
+    for (unsigned mask = maze->moveMasks[MAZE_INDEX(maze, r, c)]; mask; mask &= mask - 1) {
+        int d = __builtin_ctz(mask);
+        int nr = row + HPA_ROW[d];
+        int nc = col + HPA_COL[d];
+        if (nr < 0 || nr >= rect->rows || nc < 0 || nc >= rect->cols) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 确保区块内BFS的缓冲区能容纳一个区块
+ */
+static bool reserveClusterBfs(ClusterBfs *bfs, int clusterSize) {
+    int cells = clusterSize * clusterSize;
+    if (bfs->capacity >= cells) {
+        return true;
+    }
+    free(bfs->distances);
+    free(bfs->queue);
+    free(bfs->moves);
+    bfs->distances = (int*)malloc(cells * sizeof(int));
+    bfs->queue = (int*)malloc(cells * sizeof(int));
+    bfs->moves = (uint8_t*)malloc(cells);
+    bfs->capacity = cells;
+    if (!bfs->distances || !bfs->queue || !bfs->moves) {
+        free(bfs->distances);
+        free(bfs->queue);
+        free(bfs->moves);
+        memset(bfs, 0, sizeof(ClusterBfs));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 释放区块内BFS的缓冲区
+ */
+static void freeClusterBfs(ClusterBfs *bfs) {
+    free(bfs->distances);
+    free(bfs->queue);
+    free(bfs->moves);
+    memset(bfs, 0, sizeof(ClusterBfs));
+}
+
+/**
+ * 在区块内从指定格子出发做BFS，不走出区块
+ */
+static void runClusterBfs(const HierarchicalPlanner *planner, ClusterBfs *bfs, const ClusterRect *rect, Position from) {
+    const Maze *maze = planner->maze;
+    int size = planner->clusterSize;
+    for (int r = 0; r < rect->rows; r++) {
+        for (int c = 0; c < rect->cols; c++) {
+            bfs->distances[r * size + c] = -1;
+        }
+    }
+
+    int head = 0;
+    int tail = 0;
+    int source = localIndex(planner, rect, from);
+    bfs->distances[source] = 0;
+    bfs->queue[tail++] = source;
+
+    while (head < tail) {
+        int local = bfs->queue[head++];
+        int row = local / size;
+        int col = local % size;
+        CellIndex cell = MAZE_INDEX(maze, rect->row0 + row, rect->col0 + col);
+        for (unsigned mask = maze->moveMasks[cell]; mask; mask &= mask - 1) {
+            int d = __builtin_ctz(mask);
+            int nr = row + HPA_ROW[d];
+            int nc = col + HPA_COL[d];
+            if (nr < 0 || nr >= rect->rows || nc < 0 || nc >= rect->cols) {
+                continue;
+            }
+            int neighbor = nr * size + nc;
+            if (bfs->distances[neighbor] < 0) {
+                bfs->distances[neighbor] = bfs->distances[local] + 1;
+                bfs->moves[neighbor] = (uint8_t)d;
+                bfs->queue[tail++] = neighbor;
+            }
+        }
+    }
+}
+
+/**
+ * 在区块的节点中查找指定位置的节点
+ */
+static uint32_t findClusterNode(const HierarchicalPlanner *planner, uint32_t cluster, Position pos) {
+    for (uint32_t node = planner->clusterNodes[cluster]; node < planner->clusterNodes[cluster + 1]; node++) {
+        if (planner->nodePositions[node].row == pos.row && planner->nodePositions[node].col == pos.col) {
+            return node;
+        }
+    }
+    return HPA_NO_NODE;
+}
+
+/**
+ * 求一个区块内节点两两之间不出区块的距离
+ */
+static void computeClusterDistances(HierarchicalPlanner *planner, ClusterBfs *bfs, uint32_t cluster) {
+    ClusterRect rect = clusterRect(planner, cluster);
+    uint32_t first = planner->clusterNodes[cluster];
+    uint32_t count = planner->clusterNodes[cluster + 1] - first;
+    uint16_t *matrix = planner->distances + planner->matrixOffsets[cluster];
+
+    for (uint32_t from = 0; from < count; from++) {
+        runClusterBfs(planner, bfs, &rect, planner->nodePositions[first + from]);
+        for (uint32_t to = 0; to < count; to++) {
+            int distance = bfs->distances[localIndex(planner, &rect, planner->nodePositions[first + to])];
+            matrix[from * count + to] = distance < 0 ? HPA_UNREACHABLE : (uint16_t)distance;
+        }
+    }
+}
+
+/**
+ * 预处理工作线程：不断领取区块并求区块内距离
+ */
+static void* runPlannerWorker(void *arg) {
+    PlannerBuild *build = (PlannerBuild*)arg;
+    HierarchicalPlanner *planner = build->planner;
+    ClusterBfs bfs = {NULL, NULL, NULL, 0};
+    if (!reserveClusterBfs(&bfs, planner->clusterSize)) {
+        return NULL;
+    }
+
+    for (;;) {
+        uint32_t cluster = __atomic_fetch_add(&build->nextCluster, 1, __ATOMIC_RELAXED);
+        if (cluster >= planner->clusterCount) {
+            break;
+        }
+        computeClusterDistances(planner, &bfs, cluster);
+        __atomic_fetch_add(&build->completed, 1, __ATOMIC_RELAXED);
+    }
+
+    freeClusterBfs(&bfs);
+    return NULL;
+}
+
+/**
+ * 建立分层寻路器
+ *
+ * 先顺序找出各区块边界上的节点及其跨区块的相邻节点，
+ * 再由多个线程分别领取区块，从区块内每个节点出发做不出区块的BFS。
+ * 结果与线程数无关。
+ *
+ * @param planner 输出的寻路器，使用后调用 freeHierarchicalPlanner 释放
+ * @param maze 指向迷宫结构体的指针，寻路器使用期间不能修改
+ * @param clusterSize 区块边长，0 表示使用 HPA_DEFAULT_CLUSTER_SIZE，限制在 2 到 HPA_MAX_CLUSTER_SIZE 之间
+ * @param threadCount 线程数，HPA_AUTO_THREADS 表示使用全部在线CPU
+ * @return 成功返回true，内存不足返回false
+ */
+bool buildHierarchicalPlanner(HierarchicalPlanner *planner, const Maze *maze, int clusterSize, int threadCount) {
+    memset(planner, 0, sizeof(HierarchicalPlanner));
+    planner->maze = maze;
+    if (clusterSize <= 0) {
+        clusterSize = HPA_DEFAULT_CLUSTER_SIZE;
+    }
+    if (clusterSize < 2) {
+        clusterSize = 2;
+    }
+    if (clusterSize > HPA_MAX_CLUSTER_SIZE) {
+        clusterSize = HPA_MAX_CLUSTER_SIZE;
+    }
+    planner->clusterSize = clusterSize;
+    planner->clusterRows = (maze->height + clusterSize - 1) / clusterSize;
+    planner->clusterCols = (maze->width + clusterSize - 1) / clusterSize;
+    planner->clusterCount = (uint32_t)planner->clusterRows * planner->clusterCols;
+
+    planner->clusterNodes = (uint32_t*)calloc((size_t)planner->clusterCount + 1, sizeof(uint32_t));
+    planner->matrixOffsets = (size_t*)calloc((size_t)planner->clusterCount + 1, sizeof(size_t));
+    if (!planner->clusterNodes || !planner->matrixOffsets) {
+        freeHierarchicalPlanner(planner);
+        return false;
+    }
+
+    // 统计各区块的节点数
+    for (uint32_t cluster = 0; cluster < planner->clusterCount; cluster++) {
+        ClusterRect rect = clusterRect(planner, cluster);
+        uint32_t count = 0;
+        for (int r = 0; r < rect.rows; r++) {
+            for (int c = 0; c < rect.cols; c = nextBorderCol(&rect, r, c)) {
+                if (IS_OPEN_CELL(MAZE_CELL(maze, rect.row0 + r, rect.col0 + c)) && isEntranceCell(maze, &rect, r, c)) {
+                    count++;
+                }
+            }
+        }
+        planner->clusterNodes[cluster + 1] = planner->clusterNodes[cluster] + count;
+        planner->matrixOffsets[cluster + 1] = planner->matrixOffsets[cluster] + (size_t)count * count;
+        if (count > planner->maxClusterNodes) {
+            planner->maxClusterNodes = count;
+        }
+    }
+
+    planner->nodeCount = planner->clusterNodes[planner->clusterCount];
+    size_t nodes = planner->nodeCount > 0 ? planner->nodeCount : 1;
+    planner->nodePositions = (Position*)malloc(nodes * sizeof(Position));
+    planner->crossLinks = (uint32_t*)malloc(2 * nodes * sizeof(uint32_t));
+    planner->distances = (uint16_t*)allocateBuffer((planner->matrixOffsets[planner->clusterCount] + 1) * sizeof(uint16_t));
+    if (!planner->nodePositions || !planner->crossLinks || !planner->distances) {
+        freeHierarchicalPlanner(planner);
+        return false;
+    }
+
+    // 记录节点位置
+    for (uint32_t cluster = 0; cluster < planner->clusterCount; cluster++) {
+        ClusterRect rect = clusterRect(planner, cluster);
+        uint32_t node = planner->clusterNodes[cluster];
+        for (int r = 0; r < rect.rows; r++) {
+            for (int c = 0; c < rect.cols; c = nextBorderCol(&rect, r, c)) {
+                if (IS_OPEN_CELL(MAZE_CELL(maze, rect.row0 + r, rect.col0 + c)) && isEntranceCell(maze, &rect, r, c)) {
+                    planner->nodePositions[node].row = rect.row0 + r;
+                    planner->nodePositions[node].col = rect.col0 + c;
+                    node++;
+                }
+            }
+        }
+    }
+
+    // 跨区块的相邻节点，区块边长至少为2时每个节点最多有两个
+    for (uint32_t node = 0; node < planner->nodeCount; node++) {
+        Position pos = planner->nodePositions[node];
+        ClusterRect rect = clusterRect(planner, clusterOf(planner, pos));
+        uint32_t *links = planner->crossLinks + 2 * (size_t)node;
+        int linkCount = 0;
+        links[0] = HPA_NO_NODE;
+        links[1] = HPA_NO_NODE;
+        for (unsigned mask = maze->moveMasks[MAZE_INDEX(maze, pos.row, pos.col)]; mask; mask &= mask - 1) {
+            int d = __builtin_ctz(mask);
+            Position next = {pos.row + HPA_ROW[d], pos.col + HPA_COL[d]};
+            if (next.row < rect.row0 || next.row >= rect.row0 + rect.rows ||
+                next.col < rect.col0 || next.col >= rect.col0 + rect.cols) {
+                links[linkCount++] = findClusterNode(planner, clusterOf(planner, next), next);
+            }
+        }
+    }
+
+    // 各区块内的距离多线程并行计算，调用线程也作为一个工作线程
+    if (threadCount <= HPA_AUTO_THREADS) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cpus > 0 ? (int)cpus : 1;
+    }
+    if ((uint32_t)threadCount > planner->clusterCount) {
+        threadCount = (int)planner->clusterCount;
+    }
+    PlannerBuild build = {planner, 0, 0};
+    pthread_t *threads = threadCount > 1 ? (pthread_t*)calloc(threadCount, sizeof(pthread_t)) : NULL;
+    int started = 0;
+    for (int t = 1; t < threadCount && threads; t++) {
+        if (pthread_create(&threads[started], NULL, runPlannerWorker, &build) != 0) {
+            break;
+        }
+        started++;
+    }
+    runPlannerWorker(&build);
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+
+    if (build.completed != planner->clusterCount) {
+        freeHierarchicalPlanner(planner);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 释放分层寻路器
+ *
+ * @param planner 指向寻路器的指针
+ */
+void freeHierarchicalPlanner(HierarchicalPlanner *planner) {
+    if (planner->distances) {
+        releaseBuffer(planner->distances, (planner->matrixOffsets[planner->clusterCount] + 1) * sizeof(uint16_t));
+    }
+    free(planner->clusterNodes);
+    free(planner->matrixOffsets);
+    free(planner->nodePositions);
+    free(planner->crossLinks);
+    memset(planner, 0, sizeof(HierarchicalPlanner));
+}
+
+/**
+ * 初始化搜索工作区，缓冲区在第一次查询时分配
+ *
+ * @param search 指向工作区的指针
+ */
+void initHierarchicalSearch(HierarchicalSearch *search) {
+    memset(search, 0, sizeof(HierarchicalSearch));
+}
+
+/**
+ * 释放搜索工作区
+ *
+ * @param search 指向工作区的指针
+ */
+void freeHierarchicalSearch(HierarchicalSearch *search) {
+    size_t bytes = search->capacity * sizeof(uint32_t);
+    releaseBuffer(search->costs, bytes);
+    releaseBuffer(search->stamps, bytes);
+    releaseBuffer(search->previous, bytes);
+    free(search->heap);
+    free(search->startCosts);
+    free(search->goalCosts);
+    freeClusterBfs(&search->bfs);
+    memset(search, 0, sizeof(HierarchicalSearch));
+}
+
+/**
+ * 确保工作区能容纳寻路器的所有节点和一个区块
+ */
+static bool reserveHierarchicalSearch(const HierarchicalPlanner *planner, HierarchicalSearch *search) {
+    if (search->capacity < planner->nodeCount || search->capacity == 0) {
+        size_t bytes = search->capacity * sizeof(uint32_t);
+        releaseBuffer(search->costs, bytes);
+        releaseBuffer(search->stamps, bytes);
+        releaseBuffer(search->previous, bytes);
+
+        size_t capacity = planner->nodeCount > 0 ? planner->nodeCount : 1;
+        bytes = capacity * sizeof(uint32_t);
+        search->costs = (uint32_t*)allocateBuffer(bytes);
+        search->stamps = (uint32_t*)allocateBuffer(bytes);
+        search->previous = (uint32_t*)allocateBuffer(bytes);
+        search->capacity = capacity;
+        search->stamp = 0;
+        if (!search->costs || !search->stamps || !search->previous) {
+            freeHierarchicalSearch(search);
+            return false;
+        }
+    }
+
+    if (search->clusterCapacity < planner->maxClusterNodes || search->clusterCapacity == 0) {
+        free(search->startCosts);
+        free(search->goalCosts);
+        size_t capacity = planner->maxClusterNodes > 0 ? planner->maxClusterNodes : 1;
+        search->startCosts = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+        search->goalCosts = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+        search->clusterCapacity = capacity;
+        if (!search->startCosts || !search->goalCosts) {
+            freeHierarchicalSearch(search);
+            return false;
+        }
+    }
+
+    if (!reserveClusterBfs(&search->bfs, planner->clusterSize)) {
+        freeHierarchicalSearch(search);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 向二叉堆中加入一个节点
+ */
+static bool pushHierarchicalHeap(HierarchicalSearch *search, size_t *size, uint32_t estimate, uint32_t node) {
+    if (*size == search->heapCapacity) {
+        size_t capacity = search->heapCapacity ? search->heapCapacity * 2 : 256;
+        HierarchicalHeapEntry *heap = (HierarchicalHeapEntry*)realloc(search->heap, capacity * sizeof(HierarchicalHeapEntry));
+        if (!heap) {
+            return false;
+        }
+        search->heap = heap;
+        search->heapCapacity = capacity;
+    }
+
+    HierarchicalHeapEntry *heap = search->heap;
+    size_t child = (*size)++;
+    while (child > 0) {
+        size_t parent = (child - 1) / 2;
+        if (heap[parent].estimate <= estimate) {
+            break;
+        }
+        heap[child] = heap[parent];
+        child = parent;
+    }
+    heap[child].estimate = estimate;
+    heap[child].node = node;
+    return true;
+}
+
+/**
+ * 取出二叉堆中估计值最小的节点
+ */
+static HierarchicalHeapEntry popHierarchicalHeap(HierarchicalSearch *search, size_t *size) {
+    HierarchicalHeapEntry *heap = search->heap;
+    HierarchicalHeapEntry top = heap[0];
+    HierarchicalHeapEntry last = heap[--(*size)];
+    size_t parent = 0;
+    for (;;) {
+        size_t child = 2 * parent + 1;
+        if (child >= *size) {
+            break;
+        }
+        if (child + 1 < *size && heap[child + 1].estimate < heap[child].estimate) {
+            child++;
+        }
+        if (last.estimate <= heap[child].estimate) {
+            break;
+        }
+        heap[parent] = heap[child];
+        parent = child;
+    }
+    if (*size > 0) {
+        heap[parent] = last;
+    }
+    return top;
+}
+
+/**
+ * 节点到终点的曼哈顿距离，作为A*的启发值
+ */
+static uint32_t estimateToGoal(const HierarchicalPlanner *planner, uint32_t node, Position end) {
+    Position pos = planner->nodePositions[node];
+    return (uint32_t)(abs(pos.row - end.row) + abs(pos.col - end.col));
+}
+
+/**
+ * 更新节点的距离并放入堆
+ */
+static bool relaxHierarchicalNode(const HierarchicalPlanner *planner, HierarchicalSearch *search, size_t *heapSize,
+                                  uint32_t node, uint32_t cost, uint32_t previous, Position end) {
+    if (search->stamps[node] == search->stamp && search->costs[node] <= cost) {
+        return true;
+    }
+    search->stamps[node] = search->stamp;
+    search->costs[node] = cost;
+    search->previous[node] = previous;
+    return pushHierarchicalHeap(search, heapSize, cost + estimateToGoal(planner, node, end), node);
+}
+
+/**
+ * 向路线末尾加入一个路点，leg 为从上一个路点到它的步数；步数为0时与上一个路点重合，不加入
+ */
+static bool appendWaypoint(HierarchicalRoute *route, Position pos, int leg) {
+    if (route->count > 0 && leg == 0) {
+        return true;
+    }
+    if (route->count == route->capacity) {
+        int capacity = route->capacity ? route->capacity * 2 : 16;
+        Position *waypoints = (Position*)realloc(route->waypoints, capacity * sizeof(Position));
+        if (!waypoints) {
+            return false;
+        }
+        route->waypoints = waypoints;
+        int *legLengths = (int*)realloc(route->legLengths, capacity * sizeof(int));
+        if (!legLengths) {
+            return false;
+        }
+        route->legLengths = legLengths;
+        route->capacity = capacity;
+    }
+    if (route->count > 0) {
+        route->legLengths[route->count - 1] = leg;
+    }
+    route->waypoints[route->count++] = pos;
+    return true;
+}
+
+/**
+ * 初始化抽象路线
+ *
+ * @param route 指向路线的指针
+ */
+void initHierarchicalRoute(HierarchicalRoute *route) {
+    memset(route, 0, sizeof(HierarchicalRoute));
+    route->length = -1;
+}
+
+/**
+ * 释放抽象路线
+ *
+ * @param route 指向路线的指针
+ */
+void freeHierarchicalRoute(HierarchicalRoute *route) {
+    free(route->waypoints);
+    free(route->legLengths);
+    initHierarchicalRoute(route);
+}
+
+/**
+ * 在抽象图上规划两点间的路线
+ *
+ * 先在起点和终点所在区块内各做一次BFS，得到起点到本区块各节点、
+ * 终点区块各节点到终点的距离；两点在同一区块时区块内直达也是候选。
+ * 然后在抽象图上做A*，弹出的估计值不小于已知最好结果时停止。
+ * 只给出途经的节点，各段在需要时用 refineHierarchicalLeg 展开。
+ *
+ * @param planner 寻路器
+ * @param search 可复用的搜索工作区
+ * @param start 起点
+ * @param end 终点
+ * @param route 输出的路线，可在多次规划间复用
+ * @return 找到路线返回true；不可达、位置无效或内存不足时返回false，route->length 为-1
+ */
+bool planHierarchicalRoute(const HierarchicalPlanner *planner, HierarchicalSearch *search,
+                           Position start, Position end, HierarchicalRoute *route) {
+    const Maze *maze = planner->maze;
+    route->count = 0;
+    route->length = -1;
+    if (start.row < 0 || start.row >= maze->height || start.col < 0 || start.col >= maze->width ||
+        end.row < 0 || end.row >= maze->height || end.col < 0 || end.col >= maze->width ||
+        !IS_OPEN_CELL(MAZE_CELL(maze, start.row, start.col)) || !IS_OPEN_CELL(MAZE_CELL(maze, end.row, end.col))) {
+        return false;
+    }
+    if (start.row == end.row && start.col == end.col) {
+        route->length = 0;
+        return appendWaypoint(route, start, 0);
+    }
+    if (!reserveHierarchicalSearch(planner, search)) {
+        return false;
+    }
+
+    uint32_t startCluster = clusterOf(planner, start);
+    uint32_t goalCluster = clusterOf(planner, end);
+    uint32_t startFirst = planner->clusterNodes[startCluster];
+    uint32_t startCount = planner->clusterNodes[startCluster + 1] - startFirst;
+    uint32_t goalFirst = planner->clusterNodes[goalCluster];
+    uint32_t goalCount = planner->clusterNodes[goalCluster + 1] - goalFirst;
+    uint32_t best = HPA_INFINITY;
+    uint32_t lastNode = HPA_NO_NODE;
+
+    // 起点区块内的距离，两点同区块时顺带得到区块内直达的距离
+    ClusterRect rect = clusterRect(planner, startCluster);
+    runClusterBfs(planner, &search->bfs, &rect, start);
+    for (uint32_t i = 0; i < startCount; i++) {
+        int distance = search->bfs.distances[localIndex(planner, &rect, planner->nodePositions[startFirst + i])];
+        search->startCosts[i] = distance < 0 ? HPA_INFINITY : (uint32_t)distance;
+    }
+    if (startCluster == goalCluster && search->bfs.distances[localIndex(planner, &rect, end)] >= 0) {
+        best = (uint32_t)search->bfs.distances[localIndex(planner, &rect, end)];
+    }
+
+    // 终点区块各节点到终点的距离
+    rect = clusterRect(planner, goalCluster);
+    runClusterBfs(planner, &search->bfs, &rect, end);
+    for (uint32_t i = 0; i < goalCount; i++) {
+        int distance = search->bfs.distances[localIndex(planner, &rect, planner->nodePositions[goalFirst + i])];
+        search->goalCosts[i] = distance < 0 ? HPA_INFINITY : (uint32_t)distance;
+    }
+
+    if (++search->stamp == 0) {
+        memset(search->stamps, 0, search->capacity * sizeof(uint32_t));
+        search->stamp = 1;
+    }
+    size_t heapSize = 0;
+    for (uint32_t i = 0; i < startCount; i++) {
+        if (search->startCosts[i] != HPA_INFINITY &&
+            !relaxHierarchicalNode(planner, search, &heapSize, startFirst + i, search->startCosts[i], HPA_NO_NODE, end)) {
+            return false;
+        }
+    }
+
+    while (heapSize > 0) {
+        HierarchicalHeapEntry entry = popHierarchicalHeap(search, &heapSize);
+        uint32_t node = entry.node;
+        uint32_t cost = search->costs[node];
+        if (entry.estimate > cost + estimateToGoal(planner, node, end)) {
+            continue;
+        }
+        if (entry.estimate >= best) {
+            break;
+        }
+
+        uint32_t cluster = clusterOf(planner, planner->nodePositions[node]);
+        if (cluster == goalCluster && search->goalCosts[node - goalFirst] != HPA_INFINITY &&
+            cost + search->goalCosts[node - goalFirst] < best) {
+            best = cost + search->goalCosts[node - goalFirst];
+            lastNode = node;
+        }
+
+        // 同区块的节点按预处理的距离相连
+        uint32_t first = planner->clusterNodes[cluster];
+        uint32_t count = planner->clusterNodes[cluster + 1] - first;
+        const uint16_t *row = planner->distances + planner->matrixOffsets[cluster] + (size_t)(node - first) * count;
+        for (uint32_t i = 0; i < count; i++) {
+            if (row[i] != HPA_UNREACHABLE && first + i != node &&
+                !relaxHierarchicalNode(planner, search, &heapSize, first + i, cost + row[i], node, end)) {
+                return false;
+            }
+        }
+
+        // 相邻区块的节点一步可达
+        for (int i = 0; i < 2; i++) {
+            uint32_t link = planner->crossLinks[2 * (size_t)node + i];
+            if (link != HPA_NO_NODE && !relaxHierarchicalNode(planner, search, &heapSize, link, cost + 1, node, end)) {
+                return false;
+            }
+        }
+    }
+
+    if (best == HPA_INFINITY) {
+        return false;
+    }
+
+    // 区块内直达
+    if (lastNode == HPA_NO_NODE) {
+        if (!appendWaypoint(route, start, 0) || !appendWaypoint(route, end, (int)best)) {
+            return false;
+        }
+        route->length = (int)best;
+        return true;
+    }
+
+    // 沿来路数出途经的节点数，再从后往前填入
+    int nodeCount = 0;
+    for (uint32_t node = lastNode; node != HPA_NO_NODE; node = search->previous[node]) {
+        nodeCount++;
+    }
+    int total = nodeCount + 2;
+    if (!appendWaypoint(route, start, 0)) {
+        return false;
+    }
+    for (int i = 1; i < total; i++) {
+        // 先占位，路点和各段步数稍后写入
+        if (!appendWaypoint(route, end, 1)) {
+            return false;
+        }
+    }
+    int index = nodeCount;
+    for (uint32_t node = lastNode; node != HPA_NO_NODE; node = search->previous[node]) {
+        route->waypoints[index] = planner->nodePositions[node];
+        uint32_t previous = search->previous[node];
+        route->legLengths[index - 1] = (int)(previous == HPA_NO_NODE ? search->startCosts[node - startFirst]
+                                                                      : search->costs[node] - search->costs[previous]);
+        index--;
+    }
+    route->legLengths[nodeCount] = (int)search->goalCosts[lastNode - goalFirst];
+
+    // 起点或终点本身是节点时去掉长度为0的段
+    int count = 0;
+    for (int i = 0; i < total; i++) {
+        if (i > 0 && route->legLengths[i - 1] == 0) {
+            continue;
+        }
+        if (count > 0) {
+            route->legLengths[count - 1] = route->legLengths[i - 1];
+        }
+        route->waypoints[count++] = route->waypoints[i];
+    }
+    route->count = count;
+    route->length = (int)best;
+    return true;
+}
+
+/**
+ * 把路线的一段展开成逐格的移动命令
+ *
+ * 相邻两个路点或在同一区块内（区块内BFS回溯），或分处相邻区块的两个相邻格子（一步）。
+ *
+ * @param planner 寻路器
+ * @param search 可复用的搜索工作区
+ * @param route 规划好的路线
+ * @param leg 段号，从0开始
+ * @param commands 输出缓冲区，至少能容纳 route->legLengths[leg] 个命令
+ * @return 写入的命令数，段号无效或内存不足时返回-1
+ */
+int refineHierarchicalLeg(const HierarchicalPlanner *planner, HierarchicalSearch *search,
+                          const HierarchicalRoute *route, int leg, char *commands) {
+    if (leg < 0 || leg >= route->count - 1) {
+        return -1;
+    }
+    Position from = route->waypoints[leg];
+    Position to = route->waypoints[leg + 1];
+    uint32_t cluster = clusterOf(planner, from);
+
+    if (cluster != clusterOf(planner, to)) {
+        for (int d = 0; d < 4; d++) {
+            if (from.row + HPA_ROW[d] == to.row && from.col + HPA_COL[d] == to.col) {
+                commands[0] = directionToCommand((Direction)d);
+                return 1;
+            }
+        }
+        return -1;
+    }
+
+    if (!reserveClusterBfs(&search->bfs, planner->clusterSize)) {
+        return -1;
+    }
+    ClusterRect rect = clusterRect(planner, cluster);
+    runClusterBfs(planner, &search->bfs, &rect, from);
+
+    int local = localIndex(planner, &rect, to);
+    int steps = search->bfs.distances[local];
+    if (steps < 0) {
+        return -1;
+    }
+    // 从这一段的终点沿来向回溯
+    for (int step = steps - 1; step >= 0; step--) {
+        int d = search->bfs.moves[local];
+        commands[step] = directionToCommand((Direction)d);
+        local -= HPA_ROW[d] * planner->clusterSize + HPA_COL[d];
+    }
+    return steps;
+}
+
+/**
+ * 分层求两点间最短路径长度
+ *
+ * @param planner 寻路器
+ * @param search 可复用的搜索工作区
+ * @param start 起点
+ * @param end 终点
+ * @return 最短路径长度，不可达、位置无效或内存不足时返回-1
+ */
+int hierarchicalShortestDistance(const HierarchicalPlanner *planner, HierarchicalSearch *search,
+                                 Position start, Position end) {
+    HierarchicalRoute route;
+    initHierarchicalRoute(&route);
+    planHierarchicalRoute(planner, search, start, end, &route);
+    int length = route.length;
+    freeHierarchicalRoute(&route);
+    return length;
+}
+
+/**
+ * 分层寻找最短路径并全部展开
+ *
+ * 如果缓冲区不够，path->length 仍会给出所需步数。
+ *
+ * @param planner 寻路器
+ * @param search 可复用的搜索工作区
+ * @param start 起点
+ * @param end 终点
+ * @param path 接收结果的路径，命令缓冲区由调用者提供
+ * @return 找到路径并写入缓冲区返回true，否则返回false
+ */
+bool findShortestPathHierarchical(const HierarchicalPlanner *planner, HierarchicalSearch *search,
+                                  Position start, Position end, MazePath *path) {
+    HierarchicalRoute route;
+    initHierarchicalRoute(&route);
+    path->start = start;
+    bool found = planHierarchicalRoute(planner, search, start, end, &route);
+    path->length = route.length;
+    if (found && path->length > path->capacity) {
+        found = false;
+    }
+
+    int written = 0;
+    for (int leg = 0; found && leg < route.count - 1; leg++) {
+        int steps = refineHierarchicalLeg(planner, search, &route, leg, path->commands + written);
+        if (steps < 0) {
+            found = false;
+        }
+        written += steps;
+    }
+
+    freeHierarchicalRoute(&route);
+    return found;
+}
+
+/**
+ * 建立分层寻路器计算从起点到终点的最短路径长度
+ *
+ * @param maze 指向迷宫结构体的指针
+ * @return 最短路径长度，如果不可达或内存不足则返回-1
+ */
+int calculateShortestPathLengthHierarchical(Maze *maze) {
+    HierarchicalPlanner planner;
+    if (!buildHierarchicalPlanner(&planner, maze, HPA_DEFAULT_CLUSTER_SIZE, HPA_AUTO_THREADS)) {
+        return -1;
+    }
+    HierarchicalSearch search;
+    initHierarchicalSearch(&search);
+
+    int length = hierarchicalShortestDistance(&planner, &search, maze->start, maze->exit);
+
+    freeHierarchicalSearch(&search);
+    freeHierarchicalPlanner(&planner);
+    return length;
+}
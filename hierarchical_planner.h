@@ -0,0 +1,120 @@
+#ifndef HIERARCHICAL_PLANNER_H
+#define HIERARCHICAL_PLANNER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "maze.h"
+#include "path_finder.h"
+
+// 默认的区块边长
+#define HPA_DEFAULT_CLUSTER_SIZE 32
+
+// 区块边长上限，保证区块内距离能用16位保存
+#define HPA_MAX_CLUSTER_SIZE 255
+
+// 线程数为0时使用全部在线CPU
+#define HPA_AUTO_THREADS 0
+
+// 区块内两节点之间走不通
+#define HPA_UNREACHABLE UINT16_MAX
+
+// 没有相邻节点
+#define HPA_NO_NODE UINT32_MAX
+
+// 分层寻路器
+//
+// 网格划分为固定边长的正方形区块，与相邻区块相通的边界格子作为抽象图的节点。
+// 预处理求出每个区块内节点两两之间不出区块的距离；跨区块的相邻节点之间距离为1。
+// 每一对跨边界的相邻通路格子都是节点，因此抽象图上的距离就是真实的最短距离。
+typedef struct {
+    const Maze* maze;           // 所属迷宫，寻路器使用期间不能修改
+    int clusterSize;            // 区块边长
+    int clusterRows;            // 区块行数
+    int clusterCols;            // 区块列数
+    uint32_t clusterCount;      // 区块总数
+    uint32_t* clusterNodes;     // 各区块第一个节点的编号，共 clusterCount + 1 项
+    size_t* matrixOffsets;      // 各区块距离矩阵在 distances 中的起点
+    uint16_t* distances;        // 各区块内节点两两之间的距离矩阵
+    uint32_t nodeCount;         // 节点数
+    uint32_t maxClusterNodes;   // 单个区块最多的节点数
+    Position* nodePositions;    // 各节点的位置
+    uint32_t* crossLinks;       // 每个节点在相邻区块中最多两个相邻节点，没有时为 HPA_NO_NODE
+} HierarchicalPlanner;
+
+// 区块内BFS的缓冲区，按区块内的行列编号
+typedef struct {
+    int* distances;     // 到出发格子的步数，-1 表示未到达
+    int* queue;         // 区块内格子编号队列
+    uint8_t* moves;     // 到达各格子时走的方向，用于回溯路径
+    int capacity;       // 已分配的格子数
+} ClusterBfs;
+
+// 优先队列中的条目
+typedef struct {
+    uint32_t estimate;  // 估计的总路径长度 f = g + h
+    uint32_t node;      // 节点编号
+} HierarchicalHeapEntry;
+
+// 分层寻路的搜索工作区，由调用者持有并在多次查询间复用
+typedef struct {
+    uint32_t* costs;        // 各节点的当前距离
+    uint32_t* stamps;       // 各节点最近一次被访问的搜索编号
+    uint32_t* previous;     // 到达各节点时的上一个节点，起点区块的节点为 HPA_NO_NODE
+    size_t capacity;        // 已分配的节点数
+    uint32_t stamp;         // 当前搜索编号
+    HierarchicalHeapEntry* heap;    // 二叉堆，按需倍增并在多次查询间保留
+    size_t heapCapacity;    // 二叉堆已分配的条目数
+    uint32_t* startCosts;   // 起点到起点区块各节点的距离
+    uint32_t* goalCosts;    // 终点区块各节点到终点的距离
+    size_t clusterCapacity; // startCosts 和 goalCosts 已分配的项数
+    ClusterBfs bfs;         // 区块内BFS
+} HierarchicalSearch;
+
+// 抽象路线：起点、途经的节点和终点，相邻两个路点之间的一段按需展开成逐格的命令
+typedef struct {
+    Position* waypoints;    // 路点
+    int* legLengths;        // 各段的步数，第 i 段从 waypoints[i] 到 waypoints[i + 1]
+    int count;              // 路点数
+    int capacity;           // 已分配的路点数
+    int length;             // 总步数，不可达为-1
+} HierarchicalRoute;
+
+// 建立分层寻路器，各区块的预处理多线程并行
+bool buildHierarchicalPlanner(HierarchicalPlanner *planner, const Maze *maze, int clusterSize, int threadCount);
+
+// 释放分层寻路器
+void freeHierarchicalPlanner(HierarchicalPlanner *planner);
+
+// 初始化搜索工作区
+void initHierarchicalSearch(HierarchicalSearch *search);
+
+// 释放搜索工作区
+void freeHierarchicalSearch(HierarchicalSearch *search);
+
+// 初始化抽象路线
+void initHierarchicalRoute(HierarchicalRoute *route);
+
+// 释放抽象路线
+void freeHierarchicalRoute(HierarchicalRoute *route);
+
+// 在抽象图上规划两点间的路线，不展开成逐格路径
+bool planHierarchicalRoute(const HierarchicalPlanner *planner, HierarchicalSearch *search,
+                           Position start, Position end, HierarchicalRoute *route);
+
+// 把路线的一段展开成逐格的移动命令
+int refineHierarchicalLeg(const HierarchicalPlanner *planner, HierarchicalSearch *search,
+                          const HierarchicalRoute *route, int leg, char *commands);
+
+// 分层求两点间最短路径长度
+int hierarchicalShortestDistance(const HierarchicalPlanner *planner, HierarchicalSearch *search,
+                                 Position start, Position end);
+
+// 分层寻找最短路径并全部展开
+bool findShortestPathHierarchical(const HierarchicalPlanner *planner, HierarchicalSearch *search,
+                                  Position start, Position end, MazePath *path);
+
+// 建立分层寻路器计算从起点到终点的最短路径长度
+int calculateShortestPathLengthHierarchical(Maze *maze);
+
+#endif /* HIERARCHICAL_PLANNER_H */
@@ -0,0 +1,198 @@
+#define _DEFAULT_SOURCE
+#include "input_reader.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+
+// 会终止进程的终端相关信号，收到时先恢复终端再按默认方式处理
+static const int TERMINATING_SIGNALS[] = {SIGINT, SIGTERM, SIGHUP};
+#define TERMINATING_SIGNAL_COUNT (sizeof(TERMINATING_SIGNALS) / sizeof(TERMINATING_SIGNALS[0]))
+
+// 当前处于原始模式的读取器，程序退出或被信号终止时据此恢复终端
+static InputReader *volatile rawReader = NULL;
+
+// 安装信号处理之前的处理方式，恢复终端时一并还原
+static struct sigaction savedActions[TERMINATING_SIGNAL_COUNT];
+
+/**
+ * 程序退出时恢复终端设置
+ */
+static void restoreTerminalAtExit(void) {
+    if (rawReader) {
+        closeInputReader(rawReader);
+    }
+}
+
+/**
+ * 收到终止信号时恢复终端设置，然后按默认方式重新触发该信号
+ *
+ * 只调用异步信号安全的函数。
+ */
+static void restoreTerminalOnSignal(int signal) {
+    InputReader *reader = rawReader;
+    if (reader) {
+        tcsetattr(reader->fd, TCSANOW, &reader->saved);
+    }
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = SIG_DFL;
+    sigemptyset(&action.sa_mask);
+    sigaction(signal, &action, NULL);
+    raise(signal);
+}
+
+/**
+ * 为终止信号安装恢复终端的处理函数，原本被忽略的信号保持忽略
+ */
+static void installSignalHandlers(void) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = restoreTerminalOnSignal;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < TERMINATING_SIGNAL_COUNT; i++) {
+        sigaction(TERMINATING_SIGNALS[i], NULL, &savedActions[i]);
+        if (savedActions[i].sa_handler != SIG_IGN) {
+            sigaction(TERMINATING_SIGNALS[i], &action, NULL);
+        }
+    }
+}
+
+/**
+ * 还原安装之前的信号处理方式
+ */
+static void restoreSignalHandlers(void) {
+    for (size_t i = 0; i < TERMINATING_SIGNAL_COUNT; i++) {
+        sigaction(TERMINATING_SIGNALS[i], &savedActions[i], NULL);
+    }
+}
+
+/**
+ * 打开输入读取器
+ *
+ * 输入是终端时关闭行缓冲和回显，按键立即可读；保留信号处理，Ctrl-C 仍然有效。
+ * 终端设置在 closeInputReader、程序退出或被 SIGINT/SIGTERM/SIGHUP 终止时恢复。
+ *
+ * @param reader 指向输入读取器的指针
+ * @param fd 输入的文件描述符
+ */
+void openInputReader(InputReader *reader, int fd) {
+    reader->fd = fd;
+    reader->isTerminal = isatty(fd);
+    reader->rawMode = false;
+    reader->eof = false;
+    reader->start = 0;
+    reader->end = 0;
+
+    if (!reader->isTerminal || tcgetattr(fd, &reader->saved) != 0) {
+        return;
+    }
+
+    struct termios raw = reader->saved;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSAFLUSH, &raw) == 0) {
+        reader->rawMode = true;
+        static bool exitHandlerInstalled = false;
+        if (!exitHandlerInstalled) {
+            atexit(restoreTerminalAtExit);
+            exitHandlerInstalled = true;
+        }
+        if (!rawReader) {
+            installSignalHandlers();
+        }
+        rawReader = reader;
+    }
+}
+
+/**
+ * 恢复终端设置
+ *
+ * @param reader 指向输入读取器的指针
+ */
+void closeInputReader(InputReader *reader) {
+    if (reader->rawMode) {
+        tcsetattr(reader->fd, TCSAFLUSH, &reader->saved);
+        reader->rawMode = false;
+    }
+    if (rawReader == reader) {
+        rawReader = NULL;
+        restoreSignalHandlers();
+    }
+}
+
+/**
+ * 缓冲区中是否还有未处理的输入
+ *
+ * @param reader 指向输入读取器的指针
+ * @return 有未处理的字节返回true
+ */
+bool hasPendingInput(const InputReader *reader) {
+    return reader->start < reader->end;
+}
+
+/**
+ * 等待并读入输入
+ *
+ * 缓冲区处理完后才读取，一次读入当前已到达的全部输入（最多一个缓冲区）。
+ *
+ * @param reader 指向输入读取器的指针
+ * @param timeoutMs 最长等待时间（毫秒），-1 表示一直等待
+ * @return 有可处理的输入返回true，超时、输入结束或出错返回false
+ */
+bool fillInputReader(InputReader *reader, int timeoutMs) {
+    if (hasPendingInput(reader)) {
+        return true;
+    }
+    if (reader->eof) {
+        return false;
+    }
+    reader->start = 0;
+    reader->end = 0;
+
+    struct pollfd pfd = {reader->fd, POLLIN, 0};
+    int ready = poll(&pfd, 1, timeoutMs);
+    if (ready <= 0) {
+        if (ready < 0 && errno != EINTR) {
+            reader->eof = true;
+        }
+        return false;
+    }
+
+    ssize_t count = read(reader->fd, reader->buffer, sizeof(reader->buffer));
+    if (count < 0) {
+        if (errno != EINTR && errno != EAGAIN) {
+            reader->eof = true;
+        }
+        return false;
+    }
+    if (count == 0) {
+        reader->eof = true;
+        return false;
+    }
+
+    reader->end = (size_t)count;
+    return true;
+}
+
+/**
+ * 取出下一个非空白字符
+ *
+ * @param reader 指向输入读取器的指针
+ * @param command 输出取出的字符
+ * @return 取到返回true，缓冲区中只剩空白或为空时返回false
+ */
+bool nextInputCommand(InputReader *reader, char *command) {
+    while (reader->start < reader->end) {
+        char c = reader->buffer[reader->start++];
+        if (!isspace((unsigned char)c)) {
+            *command = c;
+            return true;
+        }
+    }
+    return false;
+}
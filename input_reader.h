@@ -0,0 +1,40 @@
+#ifndef INPUT_READER_H
+#define INPUT_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <termios.h>
+
+// 输入缓冲区大小，管道或文件输入时一次读入这么多字节
+#define INPUT_BUFFER_SIZE 65536
+
+// 输入读取器
+// 终端输入时切换到原始模式，按键无需回车立即可读；
+// 文件或管道输入时整块读取。两种情况都把已到达的输入缓存起来逐个取出。
+typedef struct {
+    int fd;                             // 输入的文件描述符
+    bool isTerminal;                    // 输入是否是终端
+    bool rawMode;                       // 是否已切换到原始模式
+    struct termios saved;               // 切换前的终端设置
+    bool eof;                           // 输入是否已结束
+    size_t start;                       // 缓冲区中下一个未处理的字节
+    size_t end;                         // 缓冲区中已读入的字节数
+    char buffer[INPUT_BUFFER_SIZE];     // 输入缓冲区
+} InputReader;
+
+// 打开输入读取器，终端输入时切换到原始模式
+void openInputReader(InputReader *reader, int fd);
+
+// 恢复终端设置
+void closeInputReader(InputReader *reader);
+
+// 缓冲区中是否还有未处理的输入
+bool hasPendingInput(const InputReader *reader);
+
+// 等待并读入输入，timeoutMs 为-1时一直等待，返回是否有可处理的输入
+bool fillInputReader(InputReader *reader, int timeoutMs);
+
+// 取出下一个非空白字符，缓冲区中没有时返回false
+bool nextInputCommand(InputReader *reader, char *command);
+
+#endif /* INPUT_READER_H */
@@ -3,6 +3,101 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdarg.h>
+#include <limits.h>
+
+// 当前生效的尺寸限制，默认沿用课程要求的 5..100
+static MazeSizeLimits sizeLimits = {MIN_MAZE_SIZE, MAX_MAZE_SIZE};
+
+// 开启大迷宫模式的命令行选项
+#define LARGE_MODE_OPTION "--large"
+
+// 当前线程的错误信息缓冲区，为NULL时错误直接打印
+static _Thread_local char *errorBuffer = NULL;
+static _Thread_local size_t errorBufferSize = 0;
+
+/**
+ * 设置当前线程的错误信息缓冲区
+ * 
+ * 设置后本线程报告的第一条错误写入缓冲区（去掉行尾换行符）而不打印，
+ * 批量模式借此为每个迷宫单独记录失败原因。
+ * 
+ * @param buffer 错误信息缓冲区，NULL 表示恢复直接打印
+ * @param size 缓冲区大小
+ */
+void captureMazeErrors(char *buffer, size_t size) {
+    errorBuffer = buffer;
+    errorBufferSize = size;
+    if (buffer && size > 0) {
+        buffer[0] = '\0';
+    }
+}
+
+/**
+ * 报告迷宫加载或验证错误
+ * 
+ * @param format printf 格式的错误信息
+ */
+void reportMazeError(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (!errorBuffer) {
+        vprintf(format, args);
+    } else if (errorBufferSize > 0 && errorBuffer[0] == '\0') {
+        vsnprintf(errorBuffer, errorBufferSize, format, args);
+        size_t len = strlen(errorBuffer);
+        if (len > 0 && errorBuffer[len - 1] == '\n') {
+            errorBuffer[len - 1] = '\0';
+        }
+    }
+    va_end(args);
+}
+
+/**
+ * 设置迷宫尺寸限制
+ * 
+ * @param minSize 宽高下限
+ * @param maxSize 宽高上限，UNLIMITED_MAZE_SIZE 表示只受内存限制
+ */
+void setMazeSizeLimits(int minSize, int maxSize) {
+    sizeLimits.minSize = minSize;
+    sizeLimits.maxSize = maxSize;
+}
+
+/**
+ * 获取当前迷宫尺寸限制
+ * 
+ * @return 当前的尺寸限制
+ */
+MazeSizeLimits getMazeSizeLimits(void) {
+    return sizeLimits;
+}
+
+/**
+ * 检查单个尺寸是否在限制内
+ * 
+ * @param size 宽度或高度
+ * @return 在限制内返回true，否则返回false
+ */
+bool isMazeSizeAllowed(int size) {
+    if (size < sizeLimits.minSize) {
+        return false;
+    }
+    return sizeLimits.maxSize == UNLIMITED_MAZE_SIZE || size <= sizeLimits.maxSize;
+}
+
+/**
+ * 打印尺寸限制错误
+ * 
+ * @param name 出错的尺寸名称
+ */
+static void printSizeLimitError(const char *name) {
+    if (sizeLimits.maxSize == UNLIMITED_MAZE_SIZE) {
+        reportMazeError("错误：迷宫%s不能小于%d\n", name, sizeLimits.minSize);
+    } else {
+        reportMazeError("错误：迷宫%s必须在%d-%d之间\n", name, sizeLimits.minSize, sizeLimits.maxSize);
+    }
+}
 
 /**
  * 验证命令行参数
@@ -13,12 +108,21 @@
  */
 bool validateCommandLine(int argc, char *argv[]) {
     // 检查参数数量
-    if (argc != 4) {
+    if (argc != 4 && argc != 5) {
         printf("错误：命令行参数数量不正确\n");
-        printf("用法: %s <迷宫文件> <宽度> <高度>\n", argv[0]);
+        printf("用法: %s <迷宫文件> <宽度> <高度> [%s]\n", argv[0], LARGE_MODE_OPTION);
         return false;
     }
     
+    // 大迷宫模式下尺寸只受内存限制
+    if (argc == 5) {
+        if (strcmp(argv[4], LARGE_MODE_OPTION) != 0) {
+            printf("错误：未知选项 %s\n", argv[4]);
+            return false;
+        }
+        setMazeSizeLimits(MIN_MAZE_SIZE, UNLIMITED_MAZE_SIZE);
+    }
+    
     // 检查文件名
     const char *filename = argv[1];
     if (strlen(filename) < 5 || strcmp(filename + strlen(filename) - 4, ".txt") != 0) {
@@ -34,20 +138,78 @@ bool validateCommandLine(int argc, char *argv[]) {
     }
     fclose(file);
     
-    // 检查宽度
-    int width = atoi(argv[2]);
-    if (width < MIN_MAZE_SIZE || width > MAX_MAZE_SIZE) {
-        printf("错误：迷宫宽度必须在%d-%d之间\n", MIN_MAZE_SIZE, MAX_MAZE_SIZE);
+    // 检查宽度和高度
+    return validateMazeSize(atoi(argv[2]), atoi(argv[3]));
+}
+
+/**
+ * 检查迷宫宽高是否在尺寸限制内
+ * 
+ * @param width 迷宫宽度
+ * @param height 迷宫高度
+ * @return 都在限制内返回true，否则返回false
+ */
+bool validateMazeSize(int width, int height) {
+    if (!isMazeSizeAllowed(width)) {
+        printSizeLimitError("宽度");
+        return false;
+    }
+    if (!isMazeSizeAllowed(height)) {
+        printSizeLimitError("高度");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 从迷宫文件推断宽度和高度
+ * 
+ * 宽度取第一行的长度（不含行尾），高度取行数；最后一行可以没有换行符。
+ * 各行是否等长留给读取时的结构验证检查。
+ * 
+ * @param filename 迷宫文件名
+ * @param width 输出迷宫宽度
+ * @param height 输出迷宫高度
+ * @return 成功返回true，文件无法打开或为空时返回false
+ */
+bool detectMazeDimensions(const char *filename, int *width, int *height) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        reportMazeError("错误：无法打开迷宫文件 %s\n", filename);
         return false;
     }
     
-    // 检查高度
-    int height = atoi(argv[3]);
-    if (height < MIN_MAZE_SIZE || height > MAX_MAZE_SIZE) {
-        printf("错误：迷宫高度必须在%d-%d之间\n", MIN_MAZE_SIZE, MAX_MAZE_SIZE);
+    char buffer[65536];
+    size_t readSize;
+    int64_t firstLine = 0;
+    int64_t lines = 0;
+    bool firstLineDone = false;
+    char last = '\n';
+    
+    while ((readSize = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        for (size_t i = 0; i < readSize; i++) {
+            if (buffer[i] == '\n') {
+                lines++;
+                firstLineDone = true;
+            } else if (!firstLineDone && buffer[i] != '\r') {
+                firstLine++;
+            }
+        }
+        last = buffer[readSize - 1];
+    }
+    fclose(file);
+    
+    // 最后一行没有换行符时也算一行
+    if (last != '\n') {
+        lines++;
+    }
+    if (lines == 0 || firstLine == 0 || firstLine > INT_MAX || lines > INT_MAX) {
+        reportMazeError("错误：无法从迷宫文件 %s 推断尺寸\n", filename);
         return false;
     }
     
+    *width = (int)firstLine;
+    *height = (int)lines;
     return true;
 }
 
@@ -62,17 +224,24 @@ bool validateCommandLine(int argc, char *argv[]) {
 bool validateMazeFile(const char *filename, int width, int height) {
     FILE *file = fopen(filename, "r");
     if (!file) {
-        printf("错误：无法打开迷宫文件 %s\n", filename);
+        reportMazeError("错误：无法打开迷宫文件 %s\n", filename);
+        return false;
+    }
+    
+    // 行缓冲区按宽度分配，+2 for \n and \0
+    char *line = (char*)malloc((size_t)width + 2);
+    if (!line) {
+        reportMazeError("错误：内存分配失败\n");
+        fclose(file);
         return false;
     }
     
-    char line[MAX_MAZE_SIZE + 2]; // +2 for \n and \0
     int lineCount = 0;
     int startCount = 0;
     int exitCount = 0;
     
     // 逐行读取文件
-    while (fgets(line, sizeof(line), file) && lineCount < height) {
+    while (lineCount < height && fgets(line, width + 2, file)) {
         // 去除换行符
         int lineLen = strlen(line);
         if (line[lineLen - 1] == '\n') {
@@ -82,7 +251,8 @@ bool validateMazeFile(const char *filename, int width, int height) {
         
         // 检查行长度
         if (lineLen != width) {
-            printf("错误：第%d行长度不符合要求，应为%d，实际为%d\n", lineCount + 1, width, lineLen);
+            reportMazeError("错误：第%d行长度不符合要求，应为%d，实际为%d\n", lineCount + 1, width, lineLen);
+            free(line);
             fclose(file);
             return false;
         }
@@ -91,7 +261,8 @@ bool validateMazeFile(const char *filename, int width, int height) {
         for (int i = 0; i < lineLen; i++) {
             char c = line[i];
             if (c != WALL_CHAR && c != PATH_CHAR && c != START_CHAR && c != EXIT_CHAR) {
-                printf("错误：第%d行第%d列有无效字符 '%c'\n", lineCount + 1, i + 1, c);
+                reportMazeError("错误：第%d行第%d列有无效字符 '%c'\n", lineCount + 1, i + 1, c);
+                free(line);
                 fclose(file);
                 return false;
             }
@@ -106,81 +277,167 @@ bool validateMazeFile(const char *filename, int width, int height) {
     
     // 检查行数
     if (lineCount != height) {
-        printf("错误：迷宫高度不符合要求，应为%d，实际为%d\n", height, lineCount);
+        reportMazeError("错误：迷宫高度不符合要求，应为%d，实际为%d\n", height, lineCount);
+        free(line);
         fclose(file);
         return false;
     }
     
     // 检查起点和终点
     if (startCount == 0) {
-        printf("错误：迷宫没有起点\n");
+        reportMazeError("错误：迷宫没有起点\n");
+        free(line);
         fclose(file);
         return false;
     } else if (startCount > 1) {
-        printf("错误：迷宫有多个起点\n");
+        reportMazeError("错误：迷宫有多个起点\n");
+        free(line);
         fclose(file);
         return false;
     }
     
     if (exitCount == 0) {
-        printf("错误：迷宫没有终点\n");
+        reportMazeError("错误：迷宫没有终点\n");
+        free(line);
         fclose(file);
         return false;
     } else if (exitCount > 1) {
-        printf("错误：迷宫有多个终点\n");
+        reportMazeError("错误：迷宫有多个终点\n");
+        free(line);
         fclose(file);
         return false;
     }
     
+    free(line);
     fclose(file);
     return true;
 }
 
 /**
- * 读取迷宫文件
+ * 验证网格中的一行，同时累计并记录起点和终点
  * 
- * @param maze 指向迷宫结构体的指针
+ * @param maze 指向迷宫结构体的指针，该行已在网格中
+ * @param row 行号
+ * @param lineLen 该行实际长度（不含行尾）
+ * @param startCount 起点计数，累加
+ * @param exitCount 终点计数，累加
+ * @return 验证通过返回true，否则返回false
+ */
+bool validateMazeRow(Maze *maze, int row, int lineLen, int *startCount, int *exitCount) {
+    // 检查行长度
+    if (lineLen != maze->width) {
+        reportMazeError("错误：第%d行长度不符合要求，应为%d，实际为%d\n", row + 1, maze->width, lineLen);
+        return false;
+    }
+    
+    // 检查字符有效性，同时记录起点和终点
+    const char *cells = &MAZE_CELL(maze, row, 0);
+    for (int j = 0; j < lineLen; j++) {
+        char c = cells[j];
+        if (c == START_CHAR) {
+            if (++(*startCount) > 1) {
+                reportMazeError("错误：迷宫有多个起点（第%d行第%d列）\n", row + 1, j + 1);
+                return false;
+            }
+            maze->start.row = row;
+            maze->start.col = j;
+            maze->player.row = row;
+            maze->player.col = j;
+        } else if (c == EXIT_CHAR) {
+            if (++(*exitCount) > 1) {
+                reportMazeError("错误：迷宫有多个终点（第%d行第%d列）\n", row + 1, j + 1);
+                return false;
+            }
+            maze->exit.row = row;
+            maze->exit.col = j;
+        } else if (c != WALL_CHAR && c != PATH_CHAR) {
+            reportMazeError("错误：第%d行第%d列有无效字符 '%c'\n", row + 1, j + 1, c);
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * 验证起点和终点数量
+ * 
+ * @param startCount 起点数量
+ * @param exitCount 终点数量
+ * @return 各有且只有一个返回true，否则返回false
+ */
+bool validateStartAndExitCount(int startCount, int exitCount) {
+    if (startCount == 0) {
+        reportMazeError("错误：迷宫没有起点\n");
+        return false;
+    } else if (startCount > 1) {
+        reportMazeError("错误：迷宫有多个起点\n");
+        return false;
+    }
+    
+    if (exitCount == 0) {
+        reportMazeError("错误：迷宫没有终点\n");
+        return false;
+    } else if (exitCount > 1) {
+        reportMazeError("错误：迷宫有多个终点\n");
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * 读取并验证迷宫文件
+ * 
+ * 只打开文件一次，逐行直接读入网格，同时检查行长度、行数、
+ * 字符有效性以及起点和终点的数量，因此读完即完成全部结构验证。
+ * 行尾可以是 LF 或 CRLF。
+ * 
+ * @param maze 指向迷宫结构体的指针，网格需已按宽高分配
  * @param filename 迷宫文件名
- * @return 读取成功返回true，否则返回false
+ * @return 读取且验证通过返回true，否则返回false
  */
 bool readMazeFile(Maze *maze, const char *filename) {
     FILE *file = fopen(filename, "r");
     if (!file) {
-        printf("错误：无法打开迷宫文件 %s\n", filename);
+        reportMazeError("错误：无法打开迷宫文件 %s\n", filename);
         return false;
     }
     
+    int startCount = 0;
+    int exitCount = 0;
+    bool valid = true;
+    
     // 逐行读取文件
     for (int i = 0; i < maze->height; i++) {
-        if (!fgets(maze->grid[i], maze->width + 2, file)) { // +2 for \n and \0
-            printf("错误：读取第%d行失败\n", i + 1);
-            fclose(file);
-            return false;
+        // 直接读入网格行，fgets 会占用本行右侧的哨兵墙和下一行开头两格，读完后恢复
+        char *row = &MAZE_CELL(maze, i, 0);
+        if (!fgets(row, maze->width + 3, file)) { // +3 for \r, \n and \0
+            reportMazeError("错误：迷宫高度不符合要求，应为%d，实际为%d\n", maze->height, i);
+            valid = false;
+            break;
         }
         
         // 去除换行符
-        int lineLen = strlen(maze->grid[i]);
-        if (maze->grid[i][lineLen - 1] == '\n') {
-            maze->grid[i][lineLen - 1] = '\0';
+        int lineLen = strlen(row);
+        if (lineLen > 0 && row[lineLen - 1] == '\n') {
+            lineLen--;
+        }
+        if (lineLen > 0 && row[lineLen - 1] == '\r') {
             lineLen--;
         }
+        row[maze->width] = WALL_CHAR;
+        row[maze->width + 1] = WALL_CHAR;
+        row[maze->width + 2] = WALL_CHAR;
         
-        // 查找起点和终点
-        for (int j = 0; j < lineLen; j++) {
-            if (maze->grid[i][j] == START_CHAR) {
-                maze->start.row = i;
-                maze->start.col = j;
-                maze->player.row = i;
-                maze->player.col = j;
-            } else if (maze->grid[i][j] == EXIT_CHAR) {
-                maze->exit.row = i;
-                maze->exit.col = j;
-            }
+        if (!validateMazeRow(maze, i, lineLen, &startCount, &exitCount)) {
+            valid = false;
+            break;
         }
     }
     
     fclose(file);
-    return true;
+    return valid && validateStartAndExitCount(startCount, exitCount);
 }
 
 /**
@@ -195,39 +452,12 @@ bool validateMazeStructure(Maze *maze) {
     
     // 遍历迷宫
     for (int i = 0; i < maze->height; i++) {
-        for (int j = 0; j < maze->width; j++) {
-            char c = maze->grid[i][j];
-            
-            // 检查字符有效性
-            if (c != WALL_CHAR && c != PATH_CHAR && c != START_CHAR && c != EXIT_CHAR) {
-                printf("错误：第%d行第%d列有无效字符 '%c'\n", i + 1, j + 1, c);
-                return false;
-            }
-            
-            // 统计起点和终点
-            if (c == START_CHAR) startCount++;
-            if (c == EXIT_CHAR) exitCount++;
+        if (!validateMazeRow(maze, i, maze->width, &startCount, &exitCount)) {
+            return false;
         }
     }
     
-    // 检查起点和终点
-    if (startCount == 0) {
-        printf("错误：迷宫没有起点\n");
-        return false;
-    } else if (startCount > 1) {
-        printf("错误：迷宫有多个起点\n");
-        return false;
-    }
-    
-    if (exitCount == 0) {
-        printf("错误：迷宫没有终点\n");
-        return false;
-    } else if (exitCount > 1) {
-        printf("错误：迷宫有多个终点\n");
-        return false;
-    }
-    
-    return true;
+    return validateStartAndExitCount(startCount, exitCount);
 }
 
 /**
@@ -239,7 +469,7 @@ bool validateMazeStructure(Maze *maze) {
 bool validateInputCommand(char command) {
     command = tolower(command);
     return command == 'w' || command == 's' || command == 'a' || command == 'd' || 
-           command == 'm' || command == 'q';
+           command == 'm' || command == 'h' || command == 'q';
 }
 
 /**
@@ -259,6 +489,11 @@ char* loadInstructions(const char *filename) {
     fseek(file, 0, SEEK_END);
     long fileSize = ftell(file);
     rewind(file);
+    if (fileSize < 0) {
+        printf("错误：读取文件失败\n");
+        fclose(file);
+        return NULL;
+    }
     
     // 分配内存
     char *buffer = (char*)malloc(fileSize + 1);
@@ -272,7 +507,7 @@ char* loadInstructions(const char *filename) {
     size_t readSize = fread(buffer, 1, fileSize, file);
     fclose(file);
     
-    if (readSize != fileSize) {
+    if (readSize != (size_t)fileSize) {
         printf("错误：读取文件失败\n");
         free(buffer);
         return NULL;
@@ -280,11 +515,11 @@ char* loadInstructions(const char *filename) {
     
     buffer[fileSize] = '\0';
     
-    // 过滤无效字符，只保留有效命令
+    // 过滤无效字符，只保留有效命令，与交互输入使用同一套规则
     int validCommandCount = 0;
     for (int i = 0; i < fileSize; i++) {
         char c = tolower(buffer[i]);
-        if (c == 'w' || c == 's' || c == 'a' || c == 'd' || c == 'm' || c == 'q') {
+        if (validateInputCommand(c)) {
             buffer[validCommandCount++] = c;
         }
     }
@@ -2,20 +2,54 @@
 #define INPUT_VALIDATOR_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include "maze.h"
 
+// 迷宫尺寸限制策略
+typedef struct {
+    int minSize;        // 宽高下限
+    int maxSize;        // 宽高上限，UNLIMITED_MAZE_SIZE 表示不限制
+} MazeSizeLimits;
+
+// 设置迷宫尺寸限制
+void setMazeSizeLimits(int minSize, int maxSize);
+
+// 获取当前迷宫尺寸限制
+MazeSizeLimits getMazeSizeLimits(void);
+
+// 检查单个尺寸是否在限制内
+bool isMazeSizeAllowed(int size);
+
+// 设置当前线程的错误信息缓冲区，NULL 表示直接打印
+void captureMazeErrors(char *buffer, size_t size);
+
+// 报告迷宫加载或验证错误
+void reportMazeError(const char *format, ...);
+
 // 验证命令行参数
 bool validateCommandLine(int argc, char *argv[]);
 
+// 检查迷宫宽高是否在尺寸限制内
+bool validateMazeSize(int width, int height);
+
+// 从迷宫文件推断宽度和高度
+bool detectMazeDimensions(const char *filename, int *width, int *height);
+
 // 验证迷宫文件格式
 bool validateMazeFile(const char *filename, int width, int height);
 
-// 读取迷宫文件
+// 读取迷宫文件，读取的同时完成结构验证
 bool readMazeFile(Maze *maze, const char *filename);
 
-// 验证迷宫结构
+// 验证迷宫结构，同时记录起点和终点位置
 bool validateMazeStructure(Maze *maze);
 
+// 验证网格中的一行并累计起点和终点数量
+bool validateMazeRow(Maze *maze, int row, int lineLen, int *startCount, int *exitCount);
+
+// 验证起点和终点数量
+bool validateStartAndExitCount(int startCount, int exitCount);
+
 // 验证输入命令有效性
 bool validateInputCommand(char command);
 
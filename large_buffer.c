@@ -0,0 +1,40 @@
+#define _DEFAULT_SOURCE
+#include "large_buffer.h"
+#include <stdlib.h>
+#include <sys/mman.h>
+
+/**
+ * 分配清零的工作缓冲区
+ * 
+ * 小缓冲区使用 calloc；大缓冲区使用匿名 mmap，
+ * 这样几亿个格子的迷宫也只为实际访问到的页面付出内存。
+ * 
+ * @param bytes 缓冲区字节数
+ * @return 缓冲区指针，失败返回NULL
+ */
+void* allocateBuffer(size_t bytes) {
+    if (bytes < LARGE_BUFFER_THRESHOLD) {
+        return calloc(1, bytes);
+    }
+    
+    void *buffer = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return buffer == MAP_FAILED ? NULL : buffer;
+}
+
+/**
+ * 释放由 allocateBuffer 分配的缓冲区
+ * 
+ * @param buffer 缓冲区指针，可为NULL
+ * @param bytes 分配时的字节数
+ */
+void releaseBuffer(void *buffer, size_t bytes) {
+    if (!buffer) {
+        return;
+    }
+    if (bytes < LARGE_BUFFER_THRESHOLD) {
+        free(buffer);
+    } else {
+        munmap(buffer, bytes);
+    }
+}
@@ -0,0 +1,15 @@
+#ifndef LARGE_BUFFER_H
+#define LARGE_BUFFER_H
+
+#include <stddef.h>
+
+// 超过该大小的缓冲区直接用 mmap 分配，页面在首次访问时才真正占用内存
+#define LARGE_BUFFER_THRESHOLD ((size_t)64 << 20)
+
+// 分配清零的工作缓冲区
+void* allocateBuffer(size_t bytes);
+
+// 释放由 allocateBuffer 分配的缓冲区
+void releaseBuffer(void *buffer, size_t bytes);
+
+#endif /* LARGE_BUFFER_H */
@@ -1,221 +1,257 @@
+#define _DEFAULT_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "maze.h"
 #include "input_validator.h"
 #include "maze_operations.h"
 #include "game_loop.h"
 #include "path_finder.h"
-
-#define MAX_MAZE_SIZE 100
-#define MIN_MAZE_SIZE 5
-
-// 迷宫中的字符定义
-#define WALL '#'
-#define PATH ' '
-#define START 'S'
-#define EXIT 'E'
-#define PLAYER 'X'
-
-// 定义方向
-typedef enum {
-    UP,
-    DOWN,
-    LEFT,
-    RIGHT
-} Direction;
-
-// 定义位置结构体
-typedef struct {
-    int row;
-    int col;
-} Position;
-
-// 定义迷宫结构体
-typedef struct {
-    char grid[MAX_MAZE_SIZE][MAX_MAZE_SIZE];
-    int height;
-    int width;
-    Position start;
-    Position exit;
-    Position player;
-} Maze;
-
-// 函数原型
-bool loadMaze(Maze *maze, const char *filename);
-bool validateMaze(Maze *maze);
-void displayMaze(Maze *maze);
-bool movePlayer(Maze *maze, Direction dir);
-void gameLoop(Maze *maze);
-void handleInput(Maze *maze, char input);
-bool isWall(Maze *maze, int row, int col);
-bool isExit(Maze *maze, int row, int col);
+#include "large_buffer.h"
+#include "batch_solver.h"
+#include "replay.h"
+#include "game_server.h"
 
 /**
- * 加载迷宫文件
- * 
- * @param maze 指向迷宫结构体的指针
- * @param filename 迷宫文件名
- * @return 成功返回true，失败返回false
+ * 将大小向上取整到页面大小的整数倍
  */
-bool loadMaze(Maze *maze, const char *filename) {
-    // 打开文件
-    // 读取迷宫数据
-    // 设置迷宫宽度和高度
-    // 查找起点和终点
-    // 设置玩家初始位置为起点
-    // 返回是否成功
-    
-    return false; // 临时返回值，实际实现时将修改
+static size_t roundUpToPage(size_t size, size_t pageSize) {
+    return (size + pageSize - 1) / pageSize * pageSize;
 }
 
 /**
- * 验证迷宫是否有效
+ * 通过内存映射加载迷宫文件，网格直接建立在映射的文件内容上
  * 
- * @param maze 指向迷宫结构体的指针
- * @return 有效返回true，无效返回false
+ * 只处理以 LF 结尾、每行恰好 width 个字符的规则文件（最后一行可以没有换行符），
+ * 此时行跨度固定为 width + 1，每行末尾的换行符充当左右两侧的哨兵。
+ * 文件映射前后各留一段填满墙的匿名页面作为上下两侧的哨兵。
+ * 网格内容不做复制，也不在这里验证，由调用者负责。
+ * 
+ * @param filename 迷宫文件名
+ * @param width 迷宫宽度
+ * @param height 迷宫高度
+ * @return 指向迷宫结构体的指针，文件布局不规则或映射失败时返回NULL
  */
-bool validateMaze(Maze *maze) {
-    // 检查迷宫大小是否在允许范围内
-    // 检查迷宫是否是矩形
-    // 检查是否有起点和终点
-    // 检查是否有无效字符
+Maze* mapMazeFile(const char* filename, int width, int height) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    
+    // 文件大小必须与固定行跨度的布局一致
+    struct stat st;
+    int stride = width + 1;
+    size_t expectedSize = (size_t)stride * height;
+    if (fstat(fd, &st) != 0 ||
+        ((size_t)st.st_size != expectedSize && (size_t)st.st_size != expectedSize - 1)) {
+        close(fd);
+        return NULL;
+    }
+    
+    size_t fileSize = (size_t)st.st_size;
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t padSize = roundUpToPage((size_t)stride + MAZE_PADDING, pageSize);
+    size_t fileSpan = roundUpToPage(fileSize, pageSize);
+    size_t mappingSize = padSize + fileSpan + padSize;
+    
+    Maze* maze = (Maze*)malloc(sizeof(Maze));
+    if (!maze) {
+        close(fd);
+        return NULL;
+    }
+    
+    // 先预留整段地址空间，再把文件映射到中间
+    char* base = (char*)mmap(NULL, mappingSize, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        free(maze);
+        close(fd);
+        return NULL;
+    }
     
-    return false; // 临时返回值，实际实现时将修改
+    char* fileView = (char*)mmap(base + padSize, fileSpan, PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_FIXED, fd, 0);
+    close(fd);
+    if (fileView == MAP_FAILED) {
+        munmap(base, mappingSize);
+        free(maze);
+        return NULL;
+    }
+    
+    memset(base, WALL_CHAR, padSize);
+    memset(base + padSize + fileSpan, WALL_CHAR, padSize);
+    
+    maze->width = width;
+    maze->height = height;
+    maze->stride = stride;
+    maze->grid = fileView;
+    maze->cells = fileView - MAZE_PADDING * stride - MAZE_PADDING;
+    maze->mapping = base;
+    maze->mappingSize = mappingSize;
+    maze->wallBits = NULL;
+    maze->wallWordsPerRow = 0;
+    maze->moveMasks = NULL;
+    maze->exitDistances = NULL;
+    
+    // 每行末尾必须是换行符（没有换行符的最后一行除外），否则交给复制加载处理
+    int terminatedRows = fileSize == expectedSize ? height : height - 1;
+    for (int i = 0; i < terminatedRows; i++) {
+        if (MAZE_CELL(maze, i, width) != '\n') {
+            freeMaze(maze);
+            return NULL;
+        }
+    }
+    
+    return maze;
 }
 
 /**
- * 显示迷宫
+ * 生成墙位图
  * 
- * @param maze 指向迷宫结构体的指针
- */
-void displayMaze(Maze *maze) {
-    // 遍历迷宫并打印
-    // 用玩家位置的字符替换起点字符
-}
-
-/**
- * 移动玩家
+ * 每格1位，1表示不可通行；每行占 wallWordsPerRow 个字，
+ * 行尾超出宽度的位也置1，位图算法因此无需单独处理右边界。
  * 
  * @param maze 指向迷宫结构体的指针
- * @param dir 移动方向
- * @return 移动成功返回true，撞墙或超出边界返回false
+ * @return 成功返回true，内存不足返回false
  */
-bool movePlayer(Maze *maze, Direction dir) {
-    // 根据方向计算新的位置
-    // 检查新位置是否是墙或超出边界
-    // 如果可以移动，更新玩家位置
+bool buildWallBitmap(Maze* maze) {
+    int wordsPerRow = (maze->width + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+    size_t words = (size_t)wordsPerRow * maze->height;
+    uint64_t* bits = (uint64_t*)allocateBuffer(words * sizeof(uint64_t));
+    if (!bits) {
+        return false;
+    }
     
-    return false; // 临时返回值，实际实现时将修改
-}
-
-/**
- * 检查位置是否是墙
- * 
- * @param maze 指向迷宫结构体的指针
- * @param row 行
- * @param col 列
- * @return 是墙返回true，否则返回false
- */
-bool isWall(Maze *maze, int row, int col) {
-    // 检查是否超出边界
-    // 检查是否是墙
+    for (int i = 0; i < maze->height; i++) {
+        const char* row = &MAZE_CELL(maze, i, 0);
+        uint64_t* rowBits = bits + (size_t)i * wordsPerRow;
+        for (int w = 0; w < wordsPerRow; w++) {
+            uint64_t word = 0;
+            int base = w * BITMAP_WORD_BITS;
+            for (int b = 0; b < BITMAP_WORD_BITS; b++) {
+                int col = base + b;
+                if (col >= maze->width || !IS_OPEN_CELL(row[col])) {
+                    word |= (uint64_t)1 << b;
+                }
+            }
+            rowBits[w] = word;
+        }
+    }
     
-    return false; // 临时返回值，实际实现时将修改
+    maze->wallBits = bits;
+    maze->wallWordsPerRow = wordsPerRow;
+    return true;
 }
 
 /**
- * 检查位置是否是出口
+ * 生成每格的可移动方向掩码
+ * 
+ * 可通行格子的第 d 位表示向方向 d 走一步后仍是可通行格子，
+ * 墙和哨兵的掩码为0。移动合法性因此只需一次查表，
+ * 落点为当前下标加上 moveOffsets 中对应的偏移。
  * 
  * @param maze 指向迷宫结构体的指针
- * @param row 行
- * @param col 列
- * @return 是出口返回true，否则返回false
+ * @return 成功返回true，内存不足返回false
  */
-bool isExit(Maze *maze, int row, int col) {
-    // 检查是否是出口位置
+bool buildMoveMasks(Maze* maze) {
+    size_t cellCount = MAZE_CELL_COUNT(maze);
+    uint8_t* masks = (uint8_t*)allocateBuffer(cellCount);
+    if (!masks) {
+        return false;
+    }
+    
+    maze->moveOffsets[UP] = -(CellIndex)maze->stride;
+    maze->moveOffsets[DOWN] = maze->stride;
+    maze->moveOffsets[LEFT] = -1;
+    maze->moveOffsets[RIGHT] = 1;
+    
+    const char* cells = maze->cells;
+    for (int i = 0; i < maze->height; i++) {
+        CellIndex index = MAZE_INDEX(maze, i, 0);
+        for (int j = 0; j < maze->width; j++, index++) {
+            if (!IS_OPEN_CELL(cells[index])) {
+                continue;
+            }
+            uint8_t mask = 0;
+            for (int d = 0; d < 4; d++) {
+                if (IS_OPEN_CELL(cells[index + maze->moveOffsets[d]])) {
+                    mask |= MOVE_BIT(d);
+                }
+            }
+            masks[index] = mask;
+        }
+    }
     
-    return false; // 临时返回值，实际实现时将修改
+    maze->moveMasks = masks;
+    return true;
 }
 
 /**
- * 处理用户输入
+ * 创建迷宫
  * 
- * @param maze 指向迷宫结构体的指针
- * @param input 用户输入
+ * @param filename 迷宫文件名
+ * @param width 迷宫宽度
+ * @param height 迷宫高度
+ * @return 指向迷宫结构体的指针，失败返回NULL
  */
-void handleInput(Maze *maze, char input) {
-    // 转换输入为小写
-    // 根据输入处理不同情况:
-    // - 'w': 向上移动
-    // - 's': 向下移动
-    // - 'a': 向左移动
-    // - 'd': 向右移动
-    // - 'm': 显示地图
-    // - 'q': 退出游戏
-    // 其他情况提示无效命令
+Maze* createMaze(const char* filename, int width, int height) {
+    // 行尾规则的文件直接映射，省去逐行复制
+    Maze* mapped = mapMazeFile(filename, width, height);
+    if (mapped) {
+        if (!validateMazeStructure(mapped) || !buildWallBitmap(mapped) || !buildMoveMasks(mapped)) {
+            freeMaze(mapped);
+            return NULL;
+        }
+        return mapped;
+    }
+    
+    // 其他文件（如 CRLF 行尾）逐行复制
+    return copyMazeFile(filename, width, height);
 }
 
 /**
- * 游戏主循环
+ * 把迷宫文件逐行复制到自有的网格中创建迷宫
  * 
- * @param maze 指向迷宫结构体的指针
- */
-void gameLoop(Maze *maze) {
-    // 显示初始说明
-    // 循环直到玩家到达出口或退出游戏
-    // 读取用户输入并处理
-    // 检查是否到达出口
-}
-
-/**
- * 创建迷宫
+ * 网格不引用文件映射，加载后文件被改写或截断都不影响迷宫，
+ * 适合需要长期保存、在多处共享的迷宫。
  * 
  * @param filename 迷宫文件名
  * @param width 迷宫宽度
  * @param height 迷宫高度
  * @return 指向迷宫结构体的指针，失败返回NULL
  */
-Maze* createMaze(const char* filename, int width, int height) {
-    // 分配迷宫结构内存
-    Maze* maze = (Maze*)malloc(sizeof(Maze));
+Maze* copyMazeFile(const char* filename, int width, int height) {
+    // 结构体和带哨兵墙的网格一次性分配
+    int stride = width + 2 * MAZE_PADDING;
+    size_t cellCount = (size_t)stride * (height + 2 * MAZE_PADDING);
+    Maze* maze = (Maze*)malloc(sizeof(Maze) + cellCount);
     if (!maze) {
         return NULL;
     }
     
     maze->width = width;
     maze->height = height;
+    maze->stride = stride;
+    maze->cells = (char*)(maze + 1);
+    maze->grid = maze->cells + MAZE_PADDING * stride + MAZE_PADDING;
+    maze->mapping = NULL;
+    maze->mappingSize = 0;
+    maze->wallBits = NULL;
+    maze->wallWordsPerRow = 0;
+    maze->moveMasks = NULL;
+    maze->exitDistances = NULL;
     
-    // 分配迷宫网格内存
-    maze->grid = (char**)malloc(height * sizeof(char*));
-    if (!maze->grid) {
-        free(maze);
-        return NULL;
-    }
-    
-    for (int i = 0; i < height; i++) {
-        maze->grid[i] = (char*)malloc((width + 1) * sizeof(char)); // +1 for null terminator
-        if (!maze->grid[i]) {
-            // 释放已分配的内存
-            for (int j = 0; j < i; j++) {
-                free(maze->grid[j]);
-            }
-            free(maze->grid);
-            free(maze);
-            return NULL;
-        }
-    }
+    // 先全部填成墙，读入后只有内部格子会被覆盖
+    memset(maze->cells, WALL_CHAR, cellCount);
     
-    // 从文件加载迷宫
-    if (!readMazeFile(maze, filename)) {
-        freeMaze(maze);
-        return NULL;
-    }
-    
-    // 验证迷宫结构
-    if (!validateMazeStructure(maze)) {
+    // 从文件加载迷宫，读取过程中一并验证结构
+    if (!readMazeFile(maze, filename) || !buildWallBitmap(maze) || !buildMoveMasks(maze)) {
         freeMaze(maze);
         return NULL;
     }
@@ -229,19 +265,33 @@ Maze* createMaze(const char* filename, int width, int height) {
  * @param maze 指向迷宫结构体的指针
  */
 void freeMaze(Maze* maze) {
-    if (maze) {
-        if (maze->grid) {
-            for (int i = 0; i < maze->height; i++) {
-                if (maze->grid[i]) {
-                    free(maze->grid[i]);
-                }
-            }
-            free(maze->grid);
-        }
-        free(maze);
+    if (!maze) {
+        return;
+    }
+    releaseBuffer(maze->wallBits, WALL_BITMAP_WORDS(maze) * sizeof(uint64_t));
+    releaseBuffer(maze->moveMasks, MAZE_CELL_COUNT(maze));
+    releaseBuffer(maze->exitDistances, MAZE_CELL_COUNT(maze) * sizeof(uint32_t));
+    if (maze->mapping) {
+        munmap(maze->mapping, maze->mappingSize);
     }
+    // 复制加载时网格与结构体在同一块内存中
+    free(maze);
 }
 
+/**
+ * 迷宫占用的内存，包括网格、墙位图、可移动方向掩码和到终点的距离表
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @return 占用的字节数
+ */
+size_t mazeMemoryUsage(const Maze* maze) {
+    size_t grid = maze->mapping ? maze->mappingSize : MAZE_CELL_COUNT(maze);
+    size_t distances = maze->exitDistances ? MAZE_CELL_COUNT(maze) * sizeof(uint32_t) : 0;
+    return sizeof(Maze) + grid + WALL_BITMAP_WORDS(maze) * sizeof(uint64_t) + MAZE_CELL_COUNT(maze) + distances;
+}
+
+// 测试程序与全部模块一起链接时定义 MAZE_NO_MAIN，去掉游戏入口
+#ifndef MAZE_NO_MAIN
 /**
  * 主函数
  * 
@@ -250,6 +300,21 @@ void freeMaze(Maze* maze) {
  * @return 程序退出码
  */
 int main(int argc, char* argv[]) {
+    // 批量模式不进入交互，直接输出每个迷宫的结果
+    if (isBatchCommandLine(argc, argv)) {
+        return runBatchMode(argc, argv);
+    }
+    
+    // 回放模式直接在内存中执行指令文件
+    if (isReplayCommandLine(argc, argv)) {
+        return runReplayMode(argc, argv);
+    }
+    
+    // 服务器模式在套接字上同时运行多个会话
+    if (isServerCommandLine(argc, argv)) {
+        return runServerMode(argc, argv);
+    }
+    
     // 验证命令行参数
     if (!validateCommandLine(argc, argv)) {
         return 1;
@@ -260,12 +325,7 @@ int main(int argc, char* argv[]) {
     int width = atoi(argv[2]);
     int height = atoi(argv[3]);
     
-    // 验证迷宫文件格式
-    if (!validateMazeFile(filename, width, height)) {
-        return 1;
-    }
-    
-    // 创建迷宫
+    // 创建迷宫，文件只读取一遍并在读取时完成验证
     Maze* maze = createMaze(filename, width, height);
     if (!maze) {
         return 1;
@@ -285,4 +345,5 @@ int main(int argc, char* argv[]) {
     freeMaze(maze);
     
     return 0;
-} 
\ No newline at end of file
+} 
+#endif /* MAZE_NO_MAIN */
@@ -5,11 +5,15 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdint.h>
 
-// 最大和最小迷宫尺寸限制
+// 默认的迷宫尺寸限制，可通过 setMazeSizeLimits 调整
 #define MAX_MAZE_SIZE 100
 #define MIN_MAZE_SIZE 5
 
+// 大迷宫模式下的尺寸上限，0 表示只受内存限制
+#define UNLIMITED_MAZE_SIZE 0
+
 // 迷宫中的各种字符
 #define WALL_CHAR '#'
 #define PATH_CHAR ' '
@@ -25,15 +29,38 @@ typedef enum {
     RIGHT
 } Direction;
 
+// 网格缓冲区下标，使用64位以支持上亿个格子的迷宫
+typedef int64_t CellIndex;
+
 // 位置结构
 typedef struct {
     int row;
     int col;
 } Position;
 
+// 格子是否可以通行；哨兵墙、换行符等其他字符都视为不可通行
+#define IS_OPEN_CELL(c) ((c) == PATH_CHAR || (c) == START_CHAR || (c) == EXIT_CHAR)
+
+// 墙位图每个字的位数
+#define BITMAP_WORD_BITS 64
+
+// 网格四周哨兵墙的宽度
+#define MAZE_PADDING 1
+
 // 迷宫结构
+// 网格保存在一块连续缓冲区中，四周各留一圈哨兵（墙或换行符），
+// 因此从任意格子向上下左右偏移一格都不会越界
 typedef struct {
-    char** grid;        // 迷宫网格
+    char* cells;        // 连续网格缓冲区（含哨兵），复制加载时与结构体一起分配
+    char* grid;         // 指向第0行第0列的格子
+    int stride;         // 行跨度，复制加载时为 width + 2 * MAZE_PADDING，映射加载时为 width + 1
+    void* mapping;      // 映射加载时的内存映射区域，否则为NULL
+    size_t mappingSize; // 内存映射区域大小
+    uint64_t* wallBits; // 墙位图，每格1位（1为不可通行），每行按字对齐，行尾多余的位也置1
+    int wallWordsPerRow;// 墙位图每行的字数
+    uint8_t* moveMasks; // 每格的可移动方向掩码，与 cells 一一对应，第 d 位表示可向方向 d 移动
+    CellIndex moveOffsets[4]; // 各方向在网格缓冲区中的下标偏移，顺序与 Direction 一致
+    uint32_t* exitDistances; // 各格到终点的步数加一（0为不可达），与 cells 一一对应，未计算时为NULL
     int width;          // 迷宫宽度
     int height;         // 迷宫高度
     Position player;    // 玩家当前位置
@@ -41,10 +68,31 @@ typedef struct {
     Position exit;      // 终点位置
 } Maze;
 
+// 按行跨度访问格子，行列允许越界一格（落在哨兵墙上）
+#define MAZE_CELL(maze, row, col) ((maze)->grid[(CellIndex)(row) * (maze)->stride + (col)])
+
+// 格子在网格缓冲区 cells 中的下标
+#define MAZE_INDEX(maze, row, col) ((CellIndex)((row) + MAZE_PADDING) * (maze)->stride + (col) + MAZE_PADDING)
+
+// 方向在可移动方向掩码中对应的位
+#define MOVE_BIT(dir) (1u << (dir))
+
+// 网格缓冲区的格子总数（含哨兵墙）
+#define MAZE_CELL_COUNT(maze) ((size_t)(maze)->stride * ((maze)->height + 2 * MAZE_PADDING))
+
+// 墙位图的字总数
+#define WALL_BITMAP_WORDS(maze) ((size_t)(maze)->wallWordsPerRow * (maze)->height)
+
 // 迷宫基本操作函数
 Maze* createMaze(const char* filename, int width, int height);
+Maze* mapMazeFile(const char* filename, int width, int height);
+Maze* copyMazeFile(const char* filename, int width, int height);
+bool buildWallBitmap(Maze* maze);
+bool buildMoveMasks(Maze* maze);
 void freeMaze(Maze* maze);
+size_t mazeMemoryUsage(const Maze* maze);
 void displayMaze(Maze* maze);
+void displayMazeAt(const Maze* maze, Position player);
 bool isReachable(Maze* maze);
 
 // 声明其他头文件中的函数
@@ -0,0 +1,317 @@
+#define _DEFAULT_SOURCE
+#include "maze_cache.h"
+#include "input_validator.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * 计算路径和宽高的 FNV-1a 哈希值
+ */
+static uint64_t hashMazeKey(const char *path, int width, int height) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char *p = (const unsigned char*)path; *p; p++) {
+        hash = (hash ^ *p) * 1099511628211ULL;
+    }
+    hash = (hash ^ (uint32_t)width) * 1099511628211ULL;
+    hash = (hash ^ (uint32_t)height) * 1099511628211ULL;
+    return hash;
+}
+
+/**
+ * 初始化迷宫缓存
+ *
+ * @param cache 指向迷宫缓存的指针
+ * @param budget 内存预算（字节），超出后淘汰最久未使用且不在使用中的条目
+ * @return 成功返回true，内存不足返回false
+ */
+bool initMazeCache(MazeCache *cache, size_t budget) {
+    memset(cache, 0, sizeof(MazeCache));
+    cache->buckets = (CachedMaze**)calloc(MAZE_CACHE_INITIAL_BUCKETS, sizeof(CachedMaze*));
+    if (!cache->buckets) {
+        return false;
+    }
+    cache->bucketCount = MAZE_CACHE_INITIAL_BUCKETS;
+    cache->budget = budget;
+    pthread_mutex_init(&cache->lock, NULL);
+    return true;
+}
+
+/**
+ * 销毁一个已从缓存中摘下的条目
+ */
+static void destroyEntry(CachedMaze *entry) {
+    freeMaze(entry->maze);
+    free(entry->path);
+    free(entry);
+}
+
+/**
+ * 释放迷宫缓存
+ *
+ * @param cache 指向迷宫缓存的指针
+ */
+void freeMazeCache(MazeCache *cache) {
+    CachedMaze *entry = cache->newest;
+    while (entry) {
+        CachedMaze *next = entry->next;
+        destroyEntry(entry);
+        entry = next;
+    }
+    free(cache->buckets);
+    pthread_mutex_destroy(&cache->lock);
+    cache->buckets = NULL;
+    cache->bucketCount = 0;
+    cache->newest = NULL;
+    cache->oldest = NULL;
+    cache->count = 0;
+    cache->bytes = 0;
+}
+
+/**
+ * 在哈希表中查找条目
+ */
+static CachedMaze* findEntry(MazeCache *cache, uint64_t hash, const char *path, int width, int height) {
+    CachedMaze *entry = cache->buckets[hash & (cache->bucketCount - 1)];
+    for (; entry; entry = entry->hashNext) {
+        if (entry->hash == hash && entry->width == width && entry->height == height &&
+            strcmp(entry->path, path) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * 从 LRU 链表中摘下条目
+ */
+static void unlinkRecent(MazeCache *cache, CachedMaze *entry) {
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        cache->newest = entry->next;
+    }
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        cache->oldest = entry->prev;
+    }
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+/**
+ * 把条目放到 LRU 链表最前面
+ */
+static void pushRecent(MazeCache *cache, CachedMaze *entry) {
+    entry->prev = NULL;
+    entry->next = cache->newest;
+    if (cache->newest) {
+        cache->newest->prev = entry;
+    } else {
+        cache->oldest = entry;
+    }
+    cache->newest = entry;
+}
+
+/**
+ * 把条目从哈希表和 LRU 链表中摘下，不再计入缓存的内存占用
+ */
+static void detachEntry(MazeCache *cache, CachedMaze *entry) {
+    CachedMaze **link = &cache->buckets[entry->hash & (cache->bucketCount - 1)];
+    while (*link != entry) {
+        link = &(*link)->hashNext;
+    }
+    *link = entry->hashNext;
+    entry->hashNext = NULL;
+
+    unlinkRecent(cache, entry);
+    cache->count--;
+    cache->bytes -= entry->bytes;
+}
+
+/**
+ * 条目数超过桶数时把哈希表扩大一倍，扩大失败时继续使用原表
+ */
+static void growBuckets(MazeCache *cache) {
+    if (cache->count <= cache->bucketCount) {
+        return;
+    }
+    size_t bucketCount = cache->bucketCount * 2;
+    CachedMaze **buckets = (CachedMaze**)calloc(bucketCount, sizeof(CachedMaze*));
+    if (!buckets) {
+        return;
+    }
+    for (size_t i = 0; i < cache->bucketCount; i++) {
+        CachedMaze *entry = cache->buckets[i];
+        while (entry) {
+            CachedMaze *next = entry->hashNext;
+            size_t bucket = entry->hash & (bucketCount - 1);
+            entry->hashNext = buckets[bucket];
+            buckets[bucket] = entry;
+            entry = next;
+        }
+    }
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucketCount = bucketCount;
+}
+
+/**
+ * 内存占用超出预算时从最久未使用的条目开始淘汰，使用中的条目跳过
+ */
+static void evictEntries(MazeCache *cache) {
+    CachedMaze *entry = cache->oldest;
+    while (entry && cache->bytes > cache->budget) {
+        CachedMaze *newer = entry->prev;
+        if (entry->refCount == 0) {
+            detachEntry(cache, entry);
+            destroyEntry(entry);
+            cache->evictions++;
+        }
+        entry = newer;
+    }
+}
+
+/**
+ * 加载并验证迷宫，同时求出可达性和最短路径长度
+ *
+ * 缓存的迷宫会长期共享，网格复制到自有内存中而不是映射文件：
+ * 映射的网格会随文件改写而变化，与加载时建立的位图不一致，文件被截断时读取还会触发 SIGBUS。
+ */
+static CachedMaze* loadEntry(const char *path, int width, int height, const struct stat *st,
+                             uint64_t hash, BfsWorkspace *workspace) {
+    CachedMaze *entry = (CachedMaze*)calloc(1, sizeof(CachedMaze));
+    char *pathCopy = strdup(path);
+    Maze *maze = entry && pathCopy ? copyMazeFile(path, width, height) : NULL;
+    if (!maze) {
+        free(pathCopy);
+        free(entry);
+        return NULL;
+    }
+
+    entry->path = pathCopy;
+    entry->width = width;
+    entry->height = height;
+    entry->mtimeSec = (int64_t)st->st_mtim.tv_sec;
+    entry->mtimeNsec = st->st_mtim.tv_nsec;
+    entry->fileSize = (int64_t)st->st_size;
+    entry->hash = hash;
+    entry->maze = maze;
+    entry->shortestPath = workspace ? calculateShortestPathLengthWith(maze, workspace, BFS_FORWARD)
+                                    : calculateShortestPathLength(maze);
+    entry->reachable = entry->shortestPath >= 0;
+    entry->bytes = sizeof(CachedMaze) + strlen(path) + 1 + mazeMemoryUsage(maze);
+    entry->refCount = 1;
+    return entry;
+}
+
+/**
+ * 条目对应的文件是否仍是缓存时的版本
+ */
+static bool isEntryCurrent(const CachedMaze *entry, const struct stat *st) {
+    return entry->mtimeSec == (int64_t)st->st_mtim.tv_sec && entry->mtimeNsec == st->st_mtim.tv_nsec &&
+           entry->fileSize == (int64_t)st->st_size;
+}
+
+/**
+ * 取得已验证的迷宫
+ *
+ * 以路径、宽高为键，文件的修改时间或大小变化后重新加载。未命中时在锁外加载，
+ * 多个线程同时加载同一迷宫时只保留先放入缓存的一份。
+ * 返回的迷宫只读，多个会话可以共用；用完后必须调用 releaseCachedMaze。
+ * 加载或验证失败时错误通过 reportMazeError 报告。
+ *
+ * @param cache 指向迷宫缓存的指针
+ * @param path 迷宫文件路径
+ * @param width 迷宫宽度
+ * @param height 迷宫高度
+ * @param workspace 未命中时计算最短路径用的工作区，NULL 表示临时分配
+ * @return 缓存条目，加载或验证失败返回NULL
+ */
+const CachedMaze* acquireCachedMaze(MazeCache *cache, const char *path, int width, int height,
+                                    BfsWorkspace *workspace) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        reportMazeError("错误：无法打开迷宫文件 %s\n", path);
+        return NULL;
+    }
+    uint64_t hash = hashMazeKey(path, width, height);
+
+    pthread_mutex_lock(&cache->lock);
+    CachedMaze *entry = findEntry(cache, hash, path, width, height);
+    if (entry && isEntryCurrent(entry, &st)) {
+        entry->refCount++;
+        unlinkRecent(cache, entry);
+        pushRecent(cache, entry);
+        cache->hits++;
+        pthread_mutex_unlock(&cache->lock);
+        return entry;
+    }
+    if (entry) {
+        // 文件已改变，旧版本仍在使用时留到最后一次释放再销毁
+        detachEntry(cache, entry);
+        if (entry->refCount == 0) {
+            destroyEntry(entry);
+        } else {
+            entry->stale = true;
+        }
+    }
+    cache->misses++;
+    pthread_mutex_unlock(&cache->lock);
+
+    CachedMaze *loaded = loadEntry(path, width, height, &st, hash, workspace);
+    if (!loaded) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    entry = findEntry(cache, hash, path, width, height);
+    if (entry && isEntryCurrent(entry, &st)) {
+        // 其他线程已经放入了同一版本
+        entry->refCount++;
+        pthread_mutex_unlock(&cache->lock);
+        destroyEntry(loaded);
+        return entry;
+    }
+    if (entry) {
+        detachEntry(cache, entry);
+        if (entry->refCount == 0) {
+            destroyEntry(entry);
+        } else {
+            entry->stale = true;
+        }
+    }
+
+    size_t bucket = hash & (cache->bucketCount - 1);
+    loaded->hashNext = cache->buckets[bucket];
+    cache->buckets[bucket] = loaded;
+    pushRecent(cache, loaded);
+    cache->count++;
+    cache->bytes += loaded->bytes;
+    growBuckets(cache);
+    evictEntries(cache);
+    pthread_mutex_unlock(&cache->lock);
+    return loaded;
+}
+
+/**
+ * 归还 acquireCachedMaze 取得的迷宫
+ *
+ * @param cache 指向迷宫缓存的指针
+ * @param entry 缓存条目
+ */
+void releaseCachedMaze(MazeCache *cache, const CachedMaze *entry) {
+    CachedMaze *mutableEntry = (CachedMaze*)entry;
+
+    pthread_mutex_lock(&cache->lock);
+    mutableEntry->refCount--;
+    if (mutableEntry->stale) {
+        if (mutableEntry->refCount == 0) {
+            destroyEntry(mutableEntry);
+        }
+    } else {
+        evictEntries(cache);
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,65 @@
+#ifndef MAZE_CACHE_H
+#define MAZE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "maze.h"
+#include "path_finder.h"
+
+// 默认的缓存内存预算
+#define MAZE_CACHE_DEFAULT_BUDGET ((size_t)256 << 20)
+
+// 哈希表的初始桶数，必须是2的幂
+#define MAZE_CACHE_INITIAL_BUCKETS 64
+
+// 缓存中的一个已验证迷宫，只读共享
+typedef struct CachedMaze {
+    char* path;                 // 迷宫文件路径
+    int width;                  // 加载时的宽度
+    int height;                 // 加载时的高度
+    int64_t mtimeSec;           // 文件修改时间（秒）
+    long mtimeNsec;             // 文件修改时间（纳秒部分）
+    int64_t fileSize;           // 文件大小
+    uint64_t hash;              // 路径和宽高的哈希值
+    Maze* maze;                 // 已验证的迷宫，使用者不得修改
+    bool reachable;             // 终点是否可达
+    int shortestPath;           // 最短路径长度，不可达为-1
+    size_t bytes;               // 占用的内存
+    int refCount;               // 正在使用的次数，大于0时不会被淘汰
+    bool stale;                 // 文件已改变，最后一次释放时销毁
+    struct CachedMaze* hashNext;    // 同一个桶中的下一个条目
+    struct CachedMaze* prev;        // LRU 链表中较新的条目
+    struct CachedMaze* next;        // LRU 链表中较旧的条目
+} CachedMaze;
+
+// 迷宫缓存，按路径、宽高和文件修改时间区分，按内存预算做 LRU 淘汰
+typedef struct {
+    CachedMaze** buckets;       // 哈希表
+    size_t bucketCount;         // 桶数
+    size_t count;               // 条目数
+    CachedMaze* newest;         // 最近使用的条目
+    CachedMaze* oldest;         // 最久未使用的条目
+    size_t bytes;               // 所有条目占用的内存
+    size_t budget;              // 内存预算
+    size_t hits;                // 命中次数
+    size_t misses;              // 未命中次数
+    size_t evictions;           // 淘汰次数
+    pthread_mutex_t lock;       // 多线程访问时保护以上字段
+} MazeCache;
+
+// 初始化迷宫缓存
+bool initMazeCache(MazeCache *cache, size_t budget);
+
+// 释放迷宫缓存，此时不应再有使用中的条目
+void freeMazeCache(MazeCache *cache);
+
+// 取得已验证的迷宫，未缓存或文件已改变时加载
+const CachedMaze* acquireCachedMaze(MazeCache *cache, const char *path, int width, int height,
+                                    BfsWorkspace *workspace);
+
+// 归还 acquireCachedMaze 取得的迷宫
+void releaseCachedMaze(MazeCache *cache, const CachedMaze *entry);
+
+#endif /* MAZE_CACHE_H */
@@ -0,0 +1,365 @@
+#include "maze_editor.h"
+#include "large_buffer.h"
+
+// 区域编号并查集的初始容量
+#define EDITOR_INITIAL_LABELS 64
+
+/**
+ * 确保并查集还能分配 extra 个新编号
+ */
+static bool reserveLabels(MazeEditor *editor, uint32_t extra) {
+    if (editor->labelCount + extra <= editor->labelCapacity) {
+        return true;
+    }
+    uint32_t capacity = editor->labelCapacity ? editor->labelCapacity : EDITOR_INITIAL_LABELS;
+    while (capacity < editor->labelCount + extra) {
+        capacity *= 2;
+    }
+    uint32_t *parents = (uint32_t*)realloc(editor->parents, (size_t)capacity * sizeof(uint32_t));
+    if (!parents) {
+        return false;
+    }
+    editor->parents = parents;
+    editor->labelCapacity = capacity;
+    return true;
+}
+
+/**
+ * 分配一个新编号，调用前需已通过 reserveLabels 预留
+ */
+static uint32_t newLabel(MazeEditor *editor) {
+    uint32_t label = editor->labelCount++;
+    editor->parents[label] = label;
+    return label;
+}
+
+/**
+ * 查找编号所在集合的代表，查找时把路径减半
+ */
+static uint32_t findLabel(MazeEditor *editor, uint32_t label) {
+    uint32_t *parents = editor->parents;
+    while (parents[label] != label) {
+        parents[label] = parents[parents[label]];
+        label = parents[label];
+    }
+    return label;
+}
+
+/**
+ * 合并两个编号所在的集合，返回合并后的代表
+ */
+static uint32_t unionLabels(MazeEditor *editor, uint32_t a, uint32_t b) {
+    a = findLabel(editor, a);
+    b = findLabel(editor, b);
+    // 较小的编号作代表
+    if (a < b) {
+        editor->parents[b] = a;
+        return a;
+    }
+    editor->parents[a] = b;
+    return b;
+}
+
+/**
+ * 打开编辑器，为迷宫的所有通路格子标号
+ *
+ * 逐行扫描一遍，每个通路格子沿用上方或左侧格子的编号，两者不同时合并，
+ * 都没有时分配新编号。
+ *
+ * @param editor 指向编辑器的指针
+ * @param maze 指向迷宫结构体的指针，编辑器打开期间不能释放
+ * @return 成功返回true，内存不足返回false
+ */
+bool openMazeEditor(MazeEditor *editor, Maze *maze) {
+    memset(editor, 0, sizeof(MazeEditor));
+    editor->maze = maze;
+    editor->labelCount = 1;
+
+    size_t cellCount = MAZE_CELL_COUNT(maze);
+    editor->labels = (uint32_t*)allocateBuffer(cellCount * sizeof(uint32_t));
+    editor->visitStamps = (uint32_t*)allocateBuffer(cellCount * sizeof(uint32_t));
+    editor->visitOwners = (uint8_t*)allocateBuffer(cellCount);
+    if (!editor->labels || !editor->visitStamps || !editor->visitOwners ||
+        !reserveLabels(editor, EDITOR_INITIAL_LABELS - 1)) {
+        closeMazeEditor(editor);
+        return false;
+    }
+
+    uint32_t *labels = editor->labels;
+    for (int i = 0; i < maze->height; i++) {
+        CellIndex index = MAZE_INDEX(maze, i, 0);
+        for (int j = 0; j < maze->width; j++, index++) {
+            if (!IS_OPEN_CELL(maze->cells[index])) {
+                continue;
+            }
+            // 哨兵和墙的编号为0
+            uint32_t up = labels[index - maze->stride];
+            uint32_t left = labels[index - 1];
+            if (up && left) {
+                labels[index] = up;
+                if (up != left) {
+                    unionLabels(editor, up, left);
+                }
+            } else if (up || left) {
+                labels[index] = up | left;
+            } else {
+                if (!reserveLabels(editor, 1)) {
+                    closeMazeEditor(editor);
+                    return false;
+                }
+                labels[index] = newLabel(editor);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * 关闭编辑器
+ *
+ * @param editor 指向编辑器的指针
+ */
+void closeMazeEditor(MazeEditor *editor) {
+    if (!editor->maze) {
+        return;
+    }
+    size_t cellCount = MAZE_CELL_COUNT(editor->maze);
+    releaseBuffer(editor->labels, cellCount * sizeof(uint32_t));
+    releaseBuffer(editor->visitStamps, cellCount * sizeof(uint32_t));
+    releaseBuffer(editor->visitOwners, cellCount);
+    for (int i = 0; i < EDITOR_SEARCH_COUNT; i++) {
+        releaseBuffer(editor->queues[i].cells, editor->queues[i].capacity * sizeof(CellIndex));
+    }
+    free(editor->parents);
+    memset(editor, 0, sizeof(MazeEditor));
+}
+
+/**
+ * 重新计算一个格子的可移动方向掩码
+ */
+static void refreshMoveMask(Maze *maze, CellIndex index) {
+    uint8_t mask = 0;
+    if (IS_OPEN_CELL(maze->cells[index])) {
+        for (int d = 0; d < 4; d++) {
+            if (IS_OPEN_CELL(maze->cells[index + maze->moveOffsets[d]])) {
+                mask |= MOVE_BIT(d);
+            }
+        }
+    }
+    maze->moveMasks[index] = mask;
+}
+
+/**
+ * 搜索 owner 所在的组，组之间相遇即合并
+ */
+static int findSearchGroup(const int *groups, int search) {
+    while (groups[search] != search) {
+        search = groups[search];
+    }
+    return search;
+}
+
+/**
+ * 把一组搜索访问过的格子全部改为新编号
+ */
+static void relabelGroup(MazeEditor *editor, const int *groups, int count, int group) {
+    uint32_t label = newLabel(editor);
+    for (int i = 0; i < count; i++) {
+        if (findSearchGroup(groups, i) != group) {
+            continue;
+        }
+        const EditorQueue *queue = &editor->queues[i];
+        for (size_t t = 0; t < queue->tail; t++) {
+            editor->labels[queue->cells[t]] = label;
+        }
+    }
+}
+
+/**
+ * 加墙后修复连通性
+ *
+ * 从原来相邻的每个通路格子各开始一个搜索，轮流各扩展一个格子。
+ * 两个搜索相遇就归为一组；某组全部走完而仍有其他组在进行，说明它被隔开了，
+ * 给它换新编号。只剩一组在进行时停止，这一组保留原编号。
+ */
+static void repairAfterWall(MazeEditor *editor, CellIndex wall) {
+    Maze *maze = editor->maze;
+    int count = 0;
+    int groups[EDITOR_SEARCH_COUNT];
+    bool finished[EDITOR_SEARCH_COUNT];
+
+    if (++editor->stamp == 0) {
+        memset(editor->visitStamps, 0, MAZE_CELL_COUNT(maze) * sizeof(uint32_t));
+        editor->stamp = 1;
+    }
+    uint32_t stamp = editor->stamp;
+
+    for (int d = 0; d < 4; d++) {
+        CellIndex neighbor = wall + maze->moveOffsets[d];
+        if (!IS_OPEN_CELL(maze->cells[neighbor])) {
+            continue;
+        }
+        EditorQueue *queue = &editor->queues[count];
+        queue->cells[0] = neighbor;
+        queue->head = 0;
+        queue->tail = 1;
+        editor->visitStamps[neighbor] = stamp;
+        editor->visitOwners[neighbor] = (uint8_t)count;
+        groups[count] = count;
+        finished[count] = false;
+        count++;
+    }
+
+    int running = count;
+    while (running > 1) {
+        for (int i = 0; i < count; i++) {
+            EditorQueue *queue = &editor->queues[i];
+            if (queue->head == queue->tail) {
+                continue;
+            }
+            CellIndex index = queue->cells[queue->head++];
+            for (unsigned mask = maze->moveMasks[index]; mask; mask &= mask - 1) {
+                CellIndex neighbor = index + maze->moveOffsets[__builtin_ctz(mask)];
+                if (editor->visitStamps[neighbor] != stamp) {
+                    editor->visitStamps[neighbor] = stamp;
+                    editor->visitOwners[neighbor] = (uint8_t)i;
+                    queue->cells[queue->tail++] = neighbor;
+                    continue;
+                }
+                int mine = findSearchGroup(groups, i);
+                int theirs = findSearchGroup(groups, editor->visitOwners[neighbor]);
+                if (mine != theirs) {
+                    groups[theirs] = mine;
+                    running--;
+                }
+            }
+        }
+
+        // 找出本轮走完的组
+        bool done[EDITOR_SEARCH_COUNT] = {false};
+        int doneCount = 0;
+        for (int g = 0; g < count; g++) {
+            if (groups[g] != g || finished[g]) {
+                continue;
+            }
+            done[g] = true;
+            for (int i = 0; i < count; i++) {
+                if (findSearchGroup(groups, i) == g && editor->queues[i].head < editor->queues[i].tail) {
+                    done[g] = false;
+                    break;
+                }
+            }
+            if (done[g]) {
+                finished[g] = true;
+                doneCount++;
+            }
+        }
+        if (doneCount == 0) {
+            continue;
+        }
+
+        // 全部同时走完时留下一组沿用原编号
+        bool keepOne = doneCount == running;
+        running -= doneCount;
+        for (int g = 0; g < count; g++) {
+            if (!done[g]) {
+                continue;
+            }
+            if (keepOne) {
+                keepOne = false;
+                continue;
+            }
+            relabelGroup(editor, groups, count, g);
+        }
+    }
+}
+
+/**
+ * 确保修复连通性用的搜索队列能容纳所有格子
+ */
+static bool reserveQueues(MazeEditor *editor) {
+    size_t cellCount = MAZE_CELL_COUNT(editor->maze);
+    for (int i = 0; i < EDITOR_SEARCH_COUNT; i++) {
+        EditorQueue *queue = &editor->queues[i];
+        if (queue->cells) {
+            continue;
+        }
+        queue->cells = (CellIndex*)allocateBuffer(cellCount * sizeof(CellIndex));
+        if (!queue->cells) {
+            return false;
+        }
+        queue->capacity = cellCount;
+    }
+    return true;
+}
+
+/**
+ * 把一个格子改为墙或通路
+ *
+ * 同时更新墙位图、可移动方向掩码和区域编号；到终点的距离表随之失效并被释放。
+ * 起点、终点和超出边界的格子不能修改。
+ *
+ * @param editor 指向编辑器的指针
+ * @param pos 格子位置
+ * @param c WALL_CHAR 或 PATH_CHAR
+ * @return 成功返回true，修改不允许或内存不足时返回false，此时迷宫不变
+ */
+bool setMazeCell(MazeEditor *editor, Position pos, char c) {
+    Maze *maze = editor->maze;
+    if (pos.row < 0 || pos.row >= maze->height || pos.col < 0 || pos.col >= maze->width ||
+        (c != WALL_CHAR && c != PATH_CHAR)) {
+        return false;
+    }
+    CellIndex index = MAZE_INDEX(maze, pos.row, pos.col);
+    char current = maze->cells[index];
+    if (current == START_CHAR || current == EXIT_CHAR) {
+        return false;
+    }
+    if (current == c) {
+        return true;
+    }
+    // 新编号和队列先准备好，之后的修改不会失败
+    if (!reserveLabels(editor, EDITOR_SEARCH_COUNT) || (c == WALL_CHAR && !reserveQueues(editor))) {
+        return false;
+    }
+
+    maze->cells[index] = c;
+    maze->wallBits[(size_t)pos.row * maze->wallWordsPerRow + pos.col / BITMAP_WORD_BITS] ^=
+        (uint64_t)1 << (pos.col % BITMAP_WORD_BITS);
+    refreshMoveMask(maze, index);
+    for (int d = 0; d < 4; d++) {
+        refreshMoveMask(maze, index + maze->moveOffsets[d]);
+    }
+    releaseBuffer(maze->exitDistances, MAZE_CELL_COUNT(maze) * sizeof(uint32_t));
+    maze->exitDistances = NULL;
+
+    if (c == WALL_CHAR) {
+        editor->labels[index] = 0;
+        repairAfterWall(editor, index);
+        return true;
+    }
+
+    // 拆墙：与相邻的所有区域合并，四周都是墙时单独成区
+    uint32_t label = 0;
+    for (int d = 0; d < 4; d++) {
+        uint32_t neighbor = editor->labels[index + maze->moveOffsets[d]];
+        if (neighbor) {
+            label = label ? unionLabels(editor, label, neighbor) : findLabel(editor, neighbor);
+        }
+    }
+    editor->labels[index] = label ? label : newLabel(editor);
+    return true;
+}
+
+/**
+ * 起点到终点当前是否连通
+ *
+ * @param editor 指向编辑器的指针
+ * @return 连通返回true，否则返回false
+ */
+bool isExitReachableInEditor(MazeEditor *editor) {
+    const Maze *maze = editor->maze;
+    uint32_t start = editor->labels[MAZE_INDEX(maze, maze->start.row, maze->start.col)];
+    uint32_t exit = editor->labels[MAZE_INDEX(maze, maze->exit.row, maze->exit.col)];
+    return findLabel(editor, start) == findLabel(editor, exit);
+}
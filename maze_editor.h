@@ -0,0 +1,49 @@
+#ifndef MAZE_EDITOR_H
+#define MAZE_EDITOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "maze.h"
+
+// 加墙后修复连通性时同时进行的搜索数，每个原相邻通路格子一个
+#define EDITOR_SEARCH_COUNT 4
+
+// 修复连通性用的搜索队列，记录访问过的全部格子，分裂出的区域据此重新标号
+typedef struct {
+    CellIndex* cells;   // 访问过的格子下标，按访问顺序
+    size_t head;        // 下一个待扩展的格子
+    size_t tail;        // 已访问的格子数
+    size_t capacity;    // 已分配的格子数
+} EditorQueue;
+
+// 迷宫编辑器，逐格修改迷宫并增量维护起点到终点的连通性
+//
+// 每个通路格子有一个区域编号，编号之间用并查集合并：拆墙时把新格子与相邻区域合并；
+// 加墙时从原来相邻的通路格子同时搜索，相遇的搜索属于同一区域，
+// 先走完的搜索说明它所在部分已被隔开，只给这一部分换新编号，代价与较小的一侧成正比。
+typedef struct {
+    Maze* maze;             // 正在编辑的迷宫
+    uint32_t* labels;       // 每格的区域编号，与 cells 一一对应，0 表示不可通行
+    uint32_t* parents;      // 区域编号的并查集，下标为编号
+    uint32_t labelCount;    // 已使用的编号数（编号0保留）
+    uint32_t labelCapacity; // 并查集已分配的编号数
+    uint32_t* visitStamps;  // 修复连通性时每格最近一次被访问的搜索编号
+    uint8_t* visitOwners;   // 修复连通性时每格由哪一个搜索访问
+    uint32_t stamp;         // 当前搜索编号，用于免清零地判断是否访问过
+    EditorQueue queues[EDITOR_SEARCH_COUNT];
+} MazeEditor;
+
+// 打开编辑器，为迷宫的所有通路格子标号
+bool openMazeEditor(MazeEditor *editor, Maze *maze);
+
+// 关闭编辑器，迷宫本身不释放
+void closeMazeEditor(MazeEditor *editor);
+
+// 把一个格子改为墙或通路，同时更新墙位图、可移动方向掩码和连通性
+bool setMazeCell(MazeEditor *editor, Position pos, char c);
+
+// 起点到终点当前是否连通
+bool isExitReachableInEditor(MazeEditor *editor);
+
+#endif /* MAZE_EDITOR_H */
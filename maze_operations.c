@@ -1,131 +1,47 @@
-#include "maze.h"
+#include "maze_operations.h"
+#include "path_finder.h"
+#include "input_validator.h"
+#include "frame_renderer.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <unistd.h>
 
 /**
- * 加载迷宫文件
+ * 显示迷宫，玩家位于迷宫记录的位置
  */
-bool loadMaze(Maze *maze, const char *filename) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        printf("ERROR: 无法打开文件 %s\n", filename);
-        return false;
-    }
-
-    // 初始化迷宫
-    memset(maze->grid, 0, sizeof(maze->grid));
-    maze->height = 0;
-    maze->width = 0;
-    maze->start.row = -1;
-    maze->start.col = -1;
-    maze->exit.row = -1;
-    maze->exit.col = -1;
-
-    // 读取迷宫
-    char line[1024];
-    while (fgets(line, sizeof(line), file)) {
-        // 移除换行符
-        line[strcspn(line, "\n")] = 0;
-        
-        // 检查宽度
-        int lineLength = strlen(line);
-        if (maze->width == 0) {
-            maze->width = lineLength;
-        } else if (lineLength != maze->width) {
-            printf("ERROR: 迷宫不是矩形\n");
-            fclose(file);
-            return false;
-        }
-
-        // 复制行到迷宫
-        if (maze->height < 100) {
-            strncpy(maze->grid[maze->height], line, maze->width);
-            
-            // 查找起点和终点
-            for (int i = 0; i < maze->width; i++) {
-                if (line[i] == 'S') {
-                    if (maze->start.row != -1) {
-                        printf("ERROR: 迷宫有多个起点\n");
-                        fclose(file);
-                        return false;
-                    }
-                    maze->start.row = maze->height;
-                    maze->start.col = i;
-                    maze->player.row = maze->height;
-                    maze->player.col = i;
-                } else if (line[i] == 'E') {
-                    if (maze->exit.row != -1) {
-                        printf("ERROR: 迷宫有多个终点\n");
-                        fclose(file);
-                        return false;
-                    }
-                    maze->exit.row = maze->height;
-                    maze->exit.col = i;
-                }
-            }
-            
-            maze->height++;
-        } else {
-            printf("ERROR: 迷宫高度超过最大值\n");
-            fclose(file);
-            return false;
-        }
-    }
-
-    fclose(file);
-    return true;
+void displayMaze(Maze *maze) {
+    displayMazeAt(maze, maze->player);
 }
 
 /**
- * 验证迷宫是否有效
+ * 显示迷宫，玩家位于指定位置
+ * 
+ * 整帧在复用的缓冲区中拼好后一次写出，玩家位置显示为 X。
+ * 游戏在两次显示之间总会输出提示，差量更新用不上，因此使用完整模式。
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @param player 玩家位置
  */
-bool validateMaze(Maze *maze) {
-    // 检查大小
-    if (maze->width < 5 || maze->width > 100 || 
-        maze->height < 5 || maze->height > 100) {
-        printf("ERROR: 迷宫大小必须在5到100之间\n");
-        return false;
-    }
-
-    // 检查起点和终点
-    if (maze->start.row == -1) {
-        printf("ERROR: 迷宫缺少起点\n");
-        return false;
-    }
-    if (maze->exit.row == -1) {
-        printf("ERROR: 迷宫缺少终点\n");
-        return false;
-    }
-
-    // 检查字符
-    for (int i = 0; i < maze->height; i++) {
-        for (int j = 0; j < maze->width; j++) {
-            char c = maze->grid[i][j];
-            if (c != '#' && c != ' ' && c != 'S' && c != 'E') {
-                printf("ERROR: 迷宫包含无效字符 '%c'\n", c);
-                return false;
-            }
-        }
+void displayMazeAt(const Maze *maze, Position player) {
+    static FrameRenderer renderer;
+    static bool initialized = false;
+    
+    if (!initialized) {
+        initFrameRenderer(&renderer, FRAME_FULL, STDOUT_FILENO);
+        initialized = true;
     }
-
-    return true;
-}
-
-/**
- * 显示迷宫
- */
-void displayMaze(Maze *maze) {
-    for (int i = 0; i < maze->height; i++) {
-        for (int j = 0; j < maze->width; j++) {
-            if (i == maze->player.row && j == maze->player.col) {
-                printf("X");
-            } else {
-                printf("%c", maze->grid[i][j]);
+    
+    // 只在缓冲区分配失败（什么也没有写出）时退回逐格输出，写出失败时再输出也不会成功
+    if (renderFrameAt(&renderer, maze, player) == FRAME_OUT_OF_MEMORY) {
+        for (int i = 0; i < maze->height; i++) {
+            for (int j = 0; j < maze->width; j++) {
+                bool isPlayer = i == player.row && j == player.col;
+                putchar(isPlayer ? PLAYER_CHAR : MAZE_CELL(maze, i, j));
             }
+            putchar('\n');
         }
-        printf("\n");
     }
 }
 
@@ -153,7 +69,7 @@ bool isWall(Maze *maze, int row, int col) {
     if (isOutOfBounds(maze, row, col)) {
         return true;
     }
-    return maze->grid[row][col] == '#';
+    return !IS_OPEN_CELL(MAZE_CELL(maze, row, col));
 }
 
 /**
@@ -169,86 +85,42 @@ bool isExit(Maze *maze, int row, int col) {
 }
 
 /**
- * 移动玩家
+ * 从指定位置移动一步
+ * 
+ * 合法性直接查当前格子的可移动方向掩码，不需要分支判断方向和边界。
+ * 迷宫只读，多个会话可以各自持有位置共用同一个迷宫。
  * 
  * @param maze 指向迷宫结构体的指针
+ * @param position 当前位置，移动成功时更新
  * @param dir 移动方向
- * @return 移动成功返回true，撞墙或超出边界返回false
+ * @return 移动结果
  */
-bool movePlayer(Maze *maze, Direction dir) {
-    int newRow = maze->player.row;
-    int newCol = maze->player.col;
-    
-    // 根据方向计算新的位置
-    switch (dir) {
-        case UP:
-            newRow--;
-            break;
-        case DOWN:
-            newRow++;
-            break;
-        case LEFT:
-            newCol--;
-            break;
-        case RIGHT:
-            newCol++;
-            break;
-    }
+MoveResult movePosition(const Maze *maze, Position *position, Direction dir) {
+    static const int ROW_STEP[4] = {-1, 1, 0, 0};
+    static const int COL_STEP[4] = {0, 0, -1, 1};
     
-    // 检查新位置是否是墙或超出边界
-    if (isWall(maze, newRow, newCol)) {
-        return false;
-    }
+    CellIndex index = MAZE_INDEX(maze, position->row, position->col);
+    int open = (maze->moveMasks[index] >> dir) & 1;
     
-    // 更新玩家位置
-    maze->player.row = newRow;
-    maze->player.col = newCol;
+    // 不能移动时增量乘以0，位置保持不变
+    position->row += open * ROW_STEP[dir];
+    position->col += open * COL_STEP[dir];
     
-    return true;
+    if (!open) {
+        return MOVE_BLOCKED;
+    }
+    return isSamePosition(*position, maze->exit) ? MOVE_REACHED_EXIT : MOVE_OK;
 }
 
 /**
- * 检查终点是否可达
+ * 移动玩家
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @param dir 移动方向
+ * @return 移动结果
  */
-bool isReachable(Maze *maze) {
-    // 使用广度优先搜索检查可达性
-    bool visited[100][100] = {false};
-    Position queue[10000];
-    int front = 0, rear = 0;
-
-    // 从起点开始
-    queue[rear++] = maze->start;
-    visited[maze->start.row][maze->start.col] = true;
-
-    while (front < rear) {
-        Position current = queue[front++];
-        
-        // 检查是否到达终点
-        if (current.row == maze->exit.row && current.col == maze->exit.col) {
-            return true;
-        }
-
-        // 尝试四个方向
-        Position directions[] = {
-            {current.row-1, current.col},  // 上
-            {current.row+1, current.col},  // 下
-            {current.row, current.col-1},  // 左
-            {current.row, current.col+1}   // 右
-        };
-
-        for (int i = 0; i < 4; i++) {
-            Position next = directions[i];
-            if (next.row >= 0 && next.row < maze->height &&
-                next.col >= 0 && next.col < maze->width &&
-                !visited[next.row][next.col] &&
-                !isWall(maze, next.row, next.col)) {
-                queue[rear++] = next;
-                visited[next.row][next.col] = true;
-            }
-        }
-    }
-
-    return false;
+MoveResult movePlayer(Maze *maze, Direction dir) {
+    return movePosition(maze, &maze->player, dir);
 }
 
 /**
@@ -259,9 +131,13 @@ bool isReachable(Maze *maze) {
  */
 bool isMazeValid(Maze *maze) {
     // 检查尺寸
-    if (maze->width < MIN_MAZE_SIZE || maze->width > MAX_MAZE_SIZE ||
-        maze->height < MIN_MAZE_SIZE || maze->height > MAX_MAZE_SIZE) {
-        printf("错误：迷宫尺寸必须在%d-%d之间\n", MIN_MAZE_SIZE, MAX_MAZE_SIZE);
+    if (!isMazeSizeAllowed(maze->width) || !isMazeSizeAllowed(maze->height)) {
+        MazeSizeLimits limits = getMazeSizeLimits();
+        if (limits.maxSize == UNLIMITED_MAZE_SIZE) {
+            printf("错误：迷宫尺寸不能小于%d\n", limits.minSize);
+        } else {
+            printf("错误：迷宫尺寸必须在%d-%d之间\n", limits.minSize, limits.maxSize);
+        }
         return false;
     }
     
@@ -286,7 +162,7 @@ bool validateStartAndExit(Maze *maze) {
     // 遍历迷宫查找起点和终点
     for (int i = 0; i < maze->height; i++) {
         for (int j = 0; j < maze->width; j++) {
-            if (maze->grid[i][j] == START_CHAR) {
+            if (MAZE_CELL(maze, i, j) == START_CHAR) {
                 if (hasStart) {
                     printf("错误：迷宫有多个起点\n");
                     return false;
@@ -296,7 +172,7 @@ bool validateStartAndExit(Maze *maze) {
                 maze->player.row = i;
                 maze->player.col = j;
                 hasStart = true;
-            } else if (maze->grid[i][j] == EXIT_CHAR) {
+            } else if (MAZE_CELL(maze, i, j) == EXIT_CHAR) {
                 if (hasExit) {
                     printf("错误：迷宫有多个终点\n");
                     return false;
@@ -4,8 +4,18 @@
 #include <stdbool.h>
 #include "maze.h"
 
+// 一步移动的结果
+typedef enum {
+    MOVE_OK,            // 移动成功
+    MOVE_BLOCKED,       // 撞墙或超出边界，位置不变
+    MOVE_REACHED_EXIT   // 移动成功并到达终点
+} MoveResult;
+
+// 从指定位置移动一步
+MoveResult movePosition(const Maze *maze, Position *position, Direction dir);
+
 // 移动玩家
-bool movePlayer(Maze *maze, Direction dir);
+MoveResult movePlayer(Maze *maze, Direction dir);
 
 // 检查位置是否是墙
 bool isWall(Maze *maze, int row, int col);
@@ -0,0 +1,259 @@
+#include "maze_regions.h"
+#include "large_buffer.h"
+#include <pthread.h>
+#include <unistd.h>
+
+// 一个线程负责的行带
+typedef struct {
+    const Maze* maze;
+    uint32_t* labels;       // 临时编号，取该区域在行带内第一个格子的下标
+    uint32_t* parents;      // 临时编号的并查集，下标即编号，总是指向更小的编号
+    int firstRow;
+    int endRow;
+} RegionBand;
+
+/**
+ * 查找临时编号的代表（集合中最小的编号），查找时把路径减半
+ */
+static uint32_t findRoot(uint32_t *parents, uint32_t label) {
+    while (parents[label] != label) {
+        parents[label] = parents[parents[label]];
+        label = parents[label];
+    }
+    return label;
+}
+
+/**
+ * 合并两个临时编号所在的集合，较大的代表指向较小的
+ */
+static void unionRoots(uint32_t *parents, uint32_t a, uint32_t b) {
+    a = findRoot(parents, a);
+    b = findRoot(parents, b);
+    if (a < b) {
+        parents[b] = a;
+    } else if (b < a) {
+        parents[a] = b;
+    }
+}
+
+/**
+ * 第一遍扫描：在行带内给每个通路格子临时编号
+ *
+ * 沿用上方（行带第一行除外）或左侧格子的编号，两者都有且不同时合并，
+ * 都没有时以自身下标作为新编号，各行带的编号因此互不重叠。
+ */
+static void* labelRegionBand(void *arg) {
+    RegionBand *band = (RegionBand*)arg;
+    const Maze *maze = band->maze;
+    uint32_t *labels = band->labels;
+    uint32_t *parents = band->parents;
+
+    for (int i = band->firstRow; i < band->endRow; i++) {
+        CellIndex index = MAZE_INDEX(maze, i, 0);
+        for (int j = 0; j < maze->width; j++, index++) {
+            if (!IS_OPEN_CELL(maze->cells[index])) {
+                continue;
+            }
+            // 墙和哨兵的编号为0
+            uint32_t up = i > band->firstRow ? labels[index - maze->stride] : 0;
+            uint32_t left = labels[index - 1];
+            if (up && left) {
+                labels[index] = up;
+                if (up != left) {
+                    unionRoots(parents, up, left);
+                }
+            } else if (up || left) {
+                labels[index] = up | left;
+            } else {
+                labels[index] = (uint32_t)index;
+                parents[index] = (uint32_t)index;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * 按行带多线程完成第一遍扫描，线程创建失败的行带由调用线程处理
+ */
+static void labelRegionBands(RegionBand *bands, int bandCount) {
+    pthread_t *threads = (pthread_t*)calloc(bandCount, sizeof(pthread_t));
+    bool *started = (bool*)calloc(bandCount, sizeof(bool));
+    if (threads && started) {
+        for (int b = 1; b < bandCount; b++) {
+            started[b] = pthread_create(&threads[b], NULL, labelRegionBand, &bands[b]) == 0;
+        }
+    }
+    labelRegionBand(&bands[0]);
+    for (int b = 1; b < bandCount; b++) {
+        if (started && started[b]) {
+            pthread_join(threads[b], NULL);
+        } else {
+            labelRegionBand(&bands[b]);
+        }
+    }
+    free(threads);
+    free(started);
+}
+
+/**
+ * 给迷宫的所有连通区域标号并统计
+ *
+ * 两遍扫描的连通区域标号：第一遍按行带并行地给格子临时编号并在带内合并，
+ * 再把相邻行带交界处上下相通的编号合并；第二遍按行优先顺序给每个集合正式编号
+ * （区域编号的顺序即各区域第一个格子的顺序），同时统计各区域。
+ * 结果与线程数无关。
+ *
+ * @param maze 指向迷宫结构体的指针
+ * @param regions 输出标号结果，使用后调用 freeMazeRegions 释放
+ * @param threadCount 线程数，MAZE_REGIONS_AUTO_THREADS 表示使用全部在线CPU
+ * @return 成功返回true，内存不足或格子数超出32位编号范围时返回false
+ */
+bool labelMazeRegions(const Maze *maze, MazeRegions *regions, int threadCount) {
+    memset(regions, 0, sizeof(MazeRegions));
+    size_t cellCount = MAZE_CELL_COUNT(maze);
+    if (cellCount > UINT32_MAX) {
+        return false;
+    }
+
+    if (threadCount <= MAZE_REGIONS_AUTO_THREADS) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cpus > 0 ? (int)cpus : 1;
+    }
+    int bandCount = maze->height / MAZE_REGIONS_MIN_BAND_ROWS;
+    if (bandCount > threadCount) {
+        bandCount = threadCount;
+    }
+    if (bandCount < 1) {
+        bandCount = 1;
+    }
+
+    uint32_t *labels = (uint32_t*)allocateBuffer(cellCount * sizeof(uint32_t));
+    uint32_t *parents = (uint32_t*)allocateBuffer(cellCount * sizeof(uint32_t));
+    RegionBand *bands = (RegionBand*)calloc(bandCount, sizeof(RegionBand));
+    if (!labels || !parents || !bands) {
+        releaseBuffer(labels, cellCount * sizeof(uint32_t));
+        releaseBuffer(parents, cellCount * sizeof(uint32_t));
+        free(bands);
+        return false;
+    }
+
+    for (int b = 0; b < bandCount; b++) {
+        bands[b].maze = maze;
+        bands[b].labels = labels;
+        bands[b].parents = parents;
+        bands[b].firstRow = (int)((int64_t)maze->height * b / bandCount);
+        bands[b].endRow = (int)((int64_t)maze->height * (b + 1) / bandCount);
+    }
+    labelRegionBands(bands, bandCount);
+
+    // 合并行带交界处上下相通的编号
+    for (int b = 1; b < bandCount; b++) {
+        CellIndex index = MAZE_INDEX(maze, bands[b].firstRow, 0);
+        for (int j = 0; j < maze->width; j++, index++) {
+            uint32_t below = labels[index];
+            uint32_t above = labels[index - maze->stride];
+            if (below && above) {
+                unionRoots(parents, below, above);
+            }
+        }
+    }
+    free(bands);
+
+    // 并查集中总是较大的编号指向较小的，按编号从小到大扫一遍即可把每个编号
+    // 直接换成正式编号：代表分配新编号，其余编号沿用父节点已换好的正式编号
+    uint32_t count = 0;
+    for (size_t label = 1; label < cellCount; label++) {
+        uint32_t parent = parents[label];
+        if (parent == 0) {
+            continue;
+        }
+        parents[label] = parent == label ? ++count : parents[parent];
+    }
+
+    MazeRegion *stats = (MazeRegion*)calloc(count > 0 ? count : 1, sizeof(MazeRegion));
+    if (!stats) {
+        releaseBuffer(labels, cellCount * sizeof(uint32_t));
+        releaseBuffer(parents, cellCount * sizeof(uint32_t));
+        return false;
+    }
+
+    // 第二遍扫描：换成正式编号并统计
+    size_t openCells = 0;
+    for (int i = 0; i < maze->height; i++) {
+        CellIndex index = MAZE_INDEX(maze, i, 0);
+        for (int j = 0; j < maze->width; j++, index++) {
+            if (!labels[index]) {
+                continue;
+            }
+            uint32_t region = parents[labels[index]];
+            labels[index] = region;
+            MazeRegion *stat = &stats[region - 1];
+            if (stat->size++ == 0) {
+                stat->first.row = i;
+                stat->first.col = j;
+                stat->minRow = i;
+                stat->minCol = j;
+                stat->maxCol = j;
+            }
+            stat->maxRow = i;
+            if (j < stat->minCol) {
+                stat->minCol = j;
+            }
+            if (j > stat->maxCol) {
+                stat->maxCol = j;
+            }
+            openCells++;
+        }
+    }
+    releaseBuffer(parents, cellCount * sizeof(uint32_t));
+
+    regions->labels = labels;
+    regions->labelCount = cellCount;
+    regions->regions = stats;
+    regions->count = count;
+    regions->startRegion = labels[MAZE_INDEX(maze, maze->start.row, maze->start.col)];
+    regions->exitRegion = labels[MAZE_INDEX(maze, maze->exit.row, maze->exit.col)];
+    regions->openCells = openCells;
+    regions->deadCells = openCells - (regions->startRegion ? stats[regions->startRegion - 1].size : 0);
+    return true;
+}
+
+/**
+ * 释放标号结果
+ *
+ * @param regions 指向标号结果的指针
+ */
+void freeMazeRegions(MazeRegions *regions) {
+    releaseBuffer(regions->labels, regions->labelCount * sizeof(uint32_t));
+    free(regions->regions);
+    memset(regions, 0, sizeof(MazeRegions));
+}
+
+/**
+ * 取得格子的区域编号
+ *
+ * @param regions 标号结果
+ * @param maze 指向迷宫结构体的指针，须是标号时的迷宫
+ * @param pos 格子位置
+ * @return 区域编号，不可通行或越界返回0
+ */
+uint32_t regionAt(const MazeRegions *regions, const Maze *maze, Position pos) {
+    if (pos.row < 0 || pos.row >= maze->height || pos.col < 0 || pos.col >= maze->width) {
+        return 0;
+    }
+    return regions->labels[MAZE_INDEX(maze, pos.row, pos.col)];
+}
+
+/**
+ * 格子是否是从起点走不到的可通行格子
+ *
+ * @param regions 标号结果
+ * @param maze 指向迷宫结构体的指针，须是标号时的迷宫
+ * @param pos 格子位置
+ * @return 可通行但不在起点所在区域时返回true
+ */
+bool isDeadCell(const MazeRegions *regions, const Maze *maze, Position pos) {
+    uint32_t region = regionAt(regions, maze, pos);
+    return region != 0 && region != regions->startRegion;
+}
@@ -0,0 +1,49 @@
+#ifndef MAZE_REGIONS_H
+#define MAZE_REGIONS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "maze.h"
+
+// 线程数为0时使用全部在线CPU
+#define MAZE_REGIONS_AUTO_THREADS 0
+
+// 每个线程至少处理的行数，行数太少时不值得多开线程
+#define MAZE_REGIONS_MIN_BAND_ROWS 64
+
+// 一个连通区域的统计
+typedef struct {
+    size_t size;        // 格子数
+    Position first;     // 按行优先顺序的第一个格子
+    int minRow;         // 外接矩形
+    int maxRow;
+    int minCol;
+    int maxCol;
+} MazeRegion;
+
+// 连通区域标号结果
+typedef struct {
+    uint32_t* labels;       // 每格的区域编号，与 cells 一一对应，0 表示不可通行，区域从1开始编号
+    size_t labelCount;      // labels 的格子数
+    MazeRegion* regions;    // 各区域的统计，regions[k - 1] 对应编号 k
+    uint32_t count;         // 区域数
+    uint32_t startRegion;   // 起点所在区域
+    uint32_t exitRegion;    // 终点所在区域
+    size_t openCells;       // 可通行格子总数
+    size_t deadCells;       // 从起点走不到的可通行格子数
+} MazeRegions;
+
+// 给迷宫的所有连通区域标号并统计，可按行带多线程处理
+bool labelMazeRegions(const Maze *maze, MazeRegions *regions, int threadCount);
+
+// 释放标号结果
+void freeMazeRegions(MazeRegions *regions);
+
+// 取得格子的区域编号，不可通行或越界返回0
+uint32_t regionAt(const MazeRegions *regions, const Maze *maze, Position pos);
+
+// 格子是否是从起点走不到的可通行格子
+bool isDeadCell(const MazeRegions *regions, const Maze *maze, Position pos);
+
+#endif /* MAZE_REGIONS_H */
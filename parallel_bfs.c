@@ -0,0 +1,445 @@
+#define _DEFAULT_SOURCE
+#include "parallel_bfs.h"
+#include "maze_operations.h"
+#include "path_finder.h"
+#include "large_buffer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// 一层的扩展方式
+typedef enum {
+    EXPAND_TOP_DOWN,    // 自顶向下：遍历当前层的格子，标记未访问的邻居
+    EXPAND_BOTTOM_UP    // 自底向上：按行检查未访问格子是否与当前层相邻
+} ExpandMode;
+
+// 线程本地的格子列表，元素为位图中的位下标
+typedef struct {
+    CellIndex* items;
+    size_t size;
+    size_t capacity;
+} CellList;
+
+// 多线程BFS的共享状态
+typedef struct {
+    Maze* maze;
+    int threadCount;
+    int words;                  // 位图每行的字数
+    CellIndex rowBits;          // 位图每行的位数
+    size_t totalWords;          // 位图的字总数
+    const uint64_t* walls;      // 墙位图
+    uint64_t* visited;          // 已访问位图
+    uint64_t* frontier;         // 当前层位图
+    uint64_t* next;             // 下一层位图
+    CellList* lists;            // 当前层格子列表，每个线程一个
+    CellList* nextLists;        // 下一层格子列表，每个线程一个
+    size_t* offsets;            // 当前层各列表的前缀和，用于平均分配
+    size_t* counts;             // 每个线程本层新到达的格子数
+    bool* failed;               // 每个线程是否发生内存分配失败
+    ExpandMode mode;            // 本层的扩展方式
+    ExpandMode nextMode;        // 下一层的扩展方式
+    CellIndex target;           // 终点的位下标
+    int distance;               // 当前层的距离
+    int result;                 // 最短路径长度，不可达为-1
+    bool done;                  // 搜索是否结束
+    bool ready;                 // 线程已全部创建，threadCount 和屏障已确定
+    pthread_mutex_t startLock;  // 保护 ready
+    pthread_cond_t startCond;   // ready 置位时通知工作线程
+    pthread_barrier_t barrier;  // 每层各阶段之间的同步点
+} ParallelBfs;
+
+// 工作线程参数
+typedef struct {
+    ParallelBfs* bfs;
+    int id;
+} ParallelBfsWorker;
+
+/**
+ * 向线程本地列表追加一个格子，容量不足时倍增
+ */
+static bool pushCell(CellList *list, CellIndex bit) {
+    if (list->size == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+        CellIndex *items = (CellIndex*)realloc(list->items, capacity * sizeof(CellIndex));
+        if (!items) {
+            return false;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->size++] = bit;
+    return true;
+}
+
+/**
+ * 自顶向下扩展时尝试访问一个邻居
+ *
+ * 通过原子或操作抢占已访问位，只有真正把该位从0置1的线程才把它加入下一层，
+ * 因此每个格子只会进入一个线程的列表。
+ */
+static void visitNeighbor(ParallelBfs *bfs, int id, CellIndex bit) {
+    size_t word = (size_t)(bit / BITMAP_WORD_BITS);
+    uint64_t mask = (uint64_t)1 << (bit % BITMAP_WORD_BITS);
+
+    if ((bfs->walls[word] & mask) || (__atomic_load_n(&bfs->visited[word], __ATOMIC_RELAXED) & mask)) {
+        return;
+    }
+    if (__atomic_fetch_or(&bfs->visited[word], mask, __ATOMIC_RELAXED) & mask) {
+        return;
+    }
+    __atomic_fetch_or(&bfs->next[word], mask, __ATOMIC_RELAXED);
+    if (!pushCell(&bfs->nextLists[id], bit)) {
+        bfs->failed[id] = true;
+    }
+    bfs->counts[id]++;
+}
+
+/**
+ * 自顶向下扩展当前层中分给本线程的一段格子
+ *
+ * 各线程按当前层的总格子数平均分段，与格子落在哪个列表中无关。
+ * 处理完的格子顺手从当前层位图中清除，使其可以作为之后的下一层位图复用。
+ */
+static void expandTopDown(ParallelBfs *bfs, int id) {
+    size_t total = bfs->offsets[bfs->threadCount];
+    size_t begin = total * id / bfs->threadCount;
+    size_t end = total * (id + 1) / bfs->threadCount;
+    Maze *maze = bfs->maze;
+
+    int list = 0;
+    while (list < bfs->threadCount - 1 && bfs->offsets[list + 1] <= begin) {
+        list++;
+    }
+    size_t position = begin - bfs->offsets[list];
+
+    for (size_t k = begin; k < end; k++) {
+        while (position >= bfs->lists[list].size) {
+            list++;
+            position = 0;
+        }
+        CellIndex bit = bfs->lists[list].items[position++];
+        __atomic_fetch_and(&bfs->frontier[bit / BITMAP_WORD_BITS],
+                           ~((uint64_t)1 << (bit % BITMAP_WORD_BITS)), __ATOMIC_RELAXED);
+
+        int row = (int)(bit / bfs->rowBits);
+        int col = (int)(bit % bfs->rowBits);
+        if (row > 0) visitNeighbor(bfs, id, bit - bfs->rowBits);
+        if (row < maze->height - 1) visitNeighbor(bfs, id, bit + bfs->rowBits);
+        if (col > 0) visitNeighbor(bfs, id, bit - 1);
+        if (col < maze->width - 1) visitNeighbor(bfs, id, bit + 1);
+    }
+}
+
+/**
+ * 自底向上扩展本线程负责的行区间
+ *
+ * 每个字一次处理64个格子：与当前层相邻、可通行且未访问的格子进入下一层。
+ * 各线程只写自己行区间内的下一层位图和已访问位图，不需要原子操作。
+ */
+static void expandBottomUp(ParallelBfs *bfs, int id, int rowBegin, int rowEnd) {
+    int words = bfs->words;
+    int height = bfs->maze->height;
+    size_t count = 0;
+
+    for (int i = rowBegin; i < rowEnd; i++) {
+        size_t offset = (size_t)i * words;
+        const uint64_t *row = bfs->frontier + offset;
+
+        for (int w = 0; w < words; w++) {
+            // 左右相邻格子，跨字的位从相邻字借入
+            uint64_t spread = (row[w] << 1) | (row[w] >> 1);
+            if (w > 0) spread |= row[w - 1] >> (BITMAP_WORD_BITS - 1);
+            if (w < words - 1) spread |= row[w + 1] << (BITMAP_WORD_BITS - 1);
+
+            // 上下相邻格子
+            if (i > 0) spread |= row[w - words];
+            if (i < height - 1) spread |= row[w + words];
+
+            uint64_t added = spread & ~bfs->walls[offset + w] & ~bfs->visited[offset + w];
+            bfs->next[offset + w] = added;
+            bfs->visited[offset + w] |= added;
+            count += (size_t)__builtin_popcountll(added);
+        }
+    }
+
+    bfs->counts[id] = count;
+}
+
+/**
+ * 把本线程行区间内的下一层位图提取为格子列表，供自顶向下扩展使用
+ */
+static void extractRows(ParallelBfs *bfs, int id, int rowBegin, int rowEnd) {
+    for (int i = rowBegin; i < rowEnd; i++) {
+        size_t offset = (size_t)i * bfs->words;
+        for (int w = 0; w < bfs->words; w++) {
+            uint64_t bits = bfs->next[offset + w];
+            while (bits) {
+                int b = __builtin_ctzll(bits);
+                bits &= bits - 1;
+                CellIndex bit = (CellIndex)(offset + w) * BITMAP_WORD_BITS + b;
+                if (!pushCell(&bfs->nextLists[id], bit)) {
+                    bfs->failed[id] = true;
+                    return;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * 一层扩展完成后由0号线程汇总：判断是否到达终点，并选择下一层的扩展方式
+ */
+static void finishLevel(ParallelBfs *bfs) {
+    size_t total = 0;
+    for (int t = 0; t < bfs->threadCount; t++) {
+        if (bfs->failed[t]) {
+            bfs->done = true;
+            return;
+        }
+        total += bfs->counts[t];
+    }
+
+    bfs->distance++;
+    size_t word = (size_t)(bfs->target / BITMAP_WORD_BITS);
+    if (bfs->next[word] & ((uint64_t)1 << (bfs->target % BITMAP_WORD_BITS))) {
+        bfs->result = bfs->distance;
+        bfs->done = true;
+        return;
+    }
+    if (total == 0) {
+        bfs->done = true;
+        return;
+    }
+
+    // 当前层较大时自底向上按字扫描更划算，较小时只处理当前层的格子
+    bfs->nextMode = total * PARALLEL_BFS_BOTTOM_UP_RATIO > bfs->totalWords
+                    ? EXPAND_BOTTOM_UP : EXPAND_TOP_DOWN;
+}
+
+/**
+ * 进入下一层：交换当前层和下一层，并重新计算列表的前缀和
+ */
+static void advanceLevel(ParallelBfs *bfs) {
+    uint64_t *bitmap = bfs->frontier;
+    bfs->frontier = bfs->next;
+    bfs->next = bitmap;
+
+    CellList *lists = bfs->lists;
+    bfs->lists = bfs->nextLists;
+    bfs->nextLists = lists;
+
+    bfs->mode = bfs->nextMode;
+    for (int t = 0; t < bfs->threadCount; t++) {
+        if (bfs->failed[t]) {
+            bfs->done = true;
+        }
+    }
+    bfs->offsets[0] = 0;
+    for (int t = 0; t < bfs->threadCount; t++) {
+        bfs->offsets[t + 1] = bfs->offsets[t] + bfs->lists[t].size;
+    }
+}
+
+/**
+ * 工作线程主体，每层依次经过扩展、汇总、整理、推进四个阶段
+ */
+static void* runParallelBfsWorker(void *arg) {
+    ParallelBfsWorker *worker = (ParallelBfsWorker*)arg;
+    ParallelBfs *bfs = worker->bfs;
+    int id = worker->id;
+
+    // 等调用线程按实际启动的线程数确定分工并初始化屏障
+    pthread_mutex_lock(&bfs->startLock);
+    while (!bfs->ready) {
+        pthread_cond_wait(&bfs->startCond, &bfs->startLock);
+    }
+    pthread_mutex_unlock(&bfs->startLock);
+
+    int height = bfs->maze->height;
+    int rowBegin = (int)((int64_t)height * id / bfs->threadCount);
+    int rowEnd = (int)((int64_t)height * (id + 1) / bfs->threadCount);
+
+    for (;;) {
+        pthread_barrier_wait(&bfs->barrier);
+        if (bfs->done) {
+            break;
+        }
+
+        // 扩展本层
+        bfs->nextLists[id].size = 0;
+        bfs->counts[id] = 0;
+        if (bfs->mode == EXPAND_TOP_DOWN) {
+            expandTopDown(bfs, id);
+        } else {
+            expandBottomUp(bfs, id, rowBegin, rowEnd);
+        }
+        pthread_barrier_wait(&bfs->barrier);
+
+        // 汇总
+        if (id == 0) {
+            finishLevel(bfs);
+        }
+        pthread_barrier_wait(&bfs->barrier);
+        if (bfs->done) {
+            break;
+        }
+
+        // 自底向上之后改回自顶向下时，清空旧的当前层位图并把下一层提取为列表
+        if (bfs->mode == EXPAND_BOTTOM_UP && bfs->nextMode == EXPAND_TOP_DOWN) {
+            size_t offset = (size_t)rowBegin * bfs->words;
+            memset(bfs->frontier + offset, 0, (size_t)(rowEnd - rowBegin) * bfs->words * sizeof(uint64_t));
+            extractRows(bfs, id, rowBegin, rowEnd);
+        }
+        pthread_barrier_wait(&bfs->barrier);
+
+        // 推进到下一层
+        if (id == 0) {
+            advanceLevel(bfs);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * 多线程按层同步的BFS，计算两点间最短路径长度
+ *
+ * 已访问集合、当前层和下一层都保存为与墙位图同样布局的位图。
+ * 当前层较小时自顶向下：把当前层平均分给各线程，用原子操作抢占已访问位；
+ * 当前层较大时自底向上：各线程按行带扫描，一个字处理64个格子。
+ * 每层结束时根据下一层大小切换方式。结果与线程数和调度无关。
+ *
+ * @param maze 指向迷宫结构体的指针，需已生成墙位图
+ * @param start 起点
+ * @param end 终点
+ * @param threadCount 线程数，PARALLEL_BFS_AUTO_THREADS 表示使用全部在线CPU
+ * @return 最短路径长度，如果不可达或资源不足则返回-1
+ */
+int parallelShortestDistance(Maze *maze, Position start, Position end, int threadCount) {
+    if (isOutOfBounds(maze, start.row, start.col) || isOutOfBounds(maze, end.row, end.col) ||
+        isWall(maze, start.row, start.col) || isWall(maze, end.row, end.col)) {
+        return -1;
+    }
+    if (isSamePosition(start, end)) {
+        return 0;
+    }
+
+    if (threadCount <= PARALLEL_BFS_AUTO_THREADS) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threadCount > maze->height) {
+        threadCount = maze->height;
+    }
+
+    ParallelBfs bfs;
+    memset(&bfs, 0, sizeof(bfs));
+    bfs.maze = maze;
+    bfs.threadCount = threadCount;
+    bfs.words = maze->wallWordsPerRow;
+    bfs.rowBits = (CellIndex)bfs.words * BITMAP_WORD_BITS;
+    bfs.totalWords = WALL_BITMAP_WORDS(maze);
+    bfs.walls = maze->wallBits;
+    bfs.target = (CellIndex)end.row * bfs.rowBits + end.col;
+    bfs.mode = EXPAND_TOP_DOWN;
+    bfs.result = -1;
+
+    size_t bitmapBytes = bfs.totalWords * sizeof(uint64_t);
+    uint64_t *bitmaps = (uint64_t*)allocateBuffer(3 * bitmapBytes);
+    CellList *lists = (CellList*)calloc(2 * threadCount, sizeof(CellList));
+    bfs.offsets = (size_t*)calloc(threadCount + 1, sizeof(size_t));
+    bfs.counts = (size_t*)calloc(threadCount, sizeof(size_t));
+    bfs.failed = (bool*)calloc(threadCount, sizeof(bool));
+    pthread_t *threads = (pthread_t*)calloc(threadCount, sizeof(pthread_t));
+    ParallelBfsWorker *workers = (ParallelBfsWorker*)calloc(threadCount, sizeof(ParallelBfsWorker));
+
+    int result = -1;
+    if (bitmaps && lists && bfs.offsets && bfs.counts && bfs.failed && threads && workers) {
+        bfs.visited = bitmaps;
+        bfs.frontier = bitmaps + bfs.totalWords;
+        bfs.next = bitmaps + 2 * bfs.totalWords;
+        bfs.lists = lists;
+        bfs.nextLists = lists + threadCount;
+
+        // 起点作为第0层
+        CellIndex source = (CellIndex)start.row * bfs.rowBits + start.col;
+        size_t word = (size_t)(source / BITMAP_WORD_BITS);
+        uint64_t mask = (uint64_t)1 << (source % BITMAP_WORD_BITS);
+        bfs.visited[word] = bfs.frontier[word] = mask;
+
+        if (pushCell(&bfs.lists[0], source)) {
+            for (int t = 0; t < threadCount; t++) {
+                bfs.offsets[t + 1] = bfs.lists[0].size;
+            }
+
+            // 先创建线程，屏障按实际启动的线程数初始化，创建失败时用较少的线程继续
+            pthread_mutex_init(&bfs.startLock, NULL);
+            pthread_cond_init(&bfs.startCond, NULL);
+            int started = 1;
+            for (int t = 1; t < threadCount; t++) {
+                workers[t].bfs = &bfs;
+                workers[t].id = t;
+                if (pthread_create(&threads[t], NULL, runParallelBfsWorker, &workers[t]) != 0) {
+                    break;
+                }
+                started++;
+            }
+
+            bfs.threadCount = started;
+            pthread_barrier_init(&bfs.barrier, NULL, (unsigned)started);
+            pthread_mutex_lock(&bfs.startLock);
+            bfs.ready = true;
+            pthread_cond_broadcast(&bfs.startCond);
+            pthread_mutex_unlock(&bfs.startLock);
+
+            workers[0].bfs = &bfs;
+            workers[0].id = 0;
+            runParallelBfsWorker(&workers[0]);
+            result = bfs.result;
+
+            for (int t = 1; t < started; t++) {
+                pthread_join(threads[t], NULL);
+            }
+            pthread_barrier_destroy(&bfs.barrier);
+            pthread_cond_destroy(&bfs.startCond);
+            pthread_mutex_destroy(&bfs.startLock);
+        }
+    }
+
+    if (lists) {
+        for (int t = 0; t < 2 * threadCount; t++) {
+            free(lists[t].items);
+        }
+    }
+    releaseBuffer(bitmaps, 3 * bitmapBytes);
+    free(lists);
+    free(bfs.offsets);
+    free(bfs.counts);
+    free(bfs.failed);
+    free(threads);
+    free(workers);
+    return result;
+}
+
+/**
+ * 多线程检查终点是否可达
+ *
+ * @param maze 指向迷宫结构体的指针
+ * @param threadCount 线程数，PARALLEL_BFS_AUTO_THREADS 表示使用全部在线CPU
+ * @return 可达返回true，否则返回false
+ */
+bool isReachableParallel(Maze *maze, int threadCount) {
+    return parallelShortestDistance(maze, maze->start, maze->exit, threadCount) >= 0;
+}
+
+/**
+ * 多线程计算从起点到终点的最短路径长度
+ *
+ * @param maze 指向迷宫结构体的指针
+ * @param threadCount 线程数，PARALLEL_BFS_AUTO_THREADS 表示使用全部在线CPU
+ * @return 最短路径长度，如果不可达则返回-1
+ */
+int calculateShortestPathLengthParallel(Maze *maze, int threadCount) {
+    return parallelShortestDistance(maze, maze->start, maze->exit, threadCount);
+}
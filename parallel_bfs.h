@@ -0,0 +1,22 @@
+#ifndef PARALLEL_BFS_H
+#define PARALLEL_BFS_H
+
+#include <stdbool.h>
+#include "maze.h"
+
+// 线程数为0时使用全部在线CPU
+#define PARALLEL_BFS_AUTO_THREADS 0
+
+// 当前层格子数乘以该系数超过位图字数时改用自底向上扩展
+#define PARALLEL_BFS_BOTTOM_UP_RATIO 4
+
+// 多线程按层同步的BFS，返回两点间最短路径长度
+int parallelShortestDistance(Maze *maze, Position start, Position end, int threadCount);
+
+// 多线程检查终点是否可达
+bool isReachableParallel(Maze *maze, int threadCount);
+
+// 多线程计算从起点到终点的最短路径长度
+int calculateShortestPathLengthParallel(Maze *maze, int threadCount);
+
+#endif /* PARALLEL_BFS_H */
@@ -1,295 +1,1103 @@
 #include "path_finder.h"
 #include "maze_operations.h"
+#include "large_buffer.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <limits.h>
 
-// 队列结构定义
-typedef struct {
-    Position* data;
-    int front;
-    int rear;
-    int size;
-    int capacity;
-} Queue;
+// 与 Direction 枚举顺序一致的移动命令和坐标偏移
+static const char DIRECTION_COMMANDS[4] = {'w', 's', 'a', 'd'};
+static const int DIRECTION_ROW[4] = {-1, 1, 0, 0};
+static const int DIRECTION_COL[4] = {0, 0, -1, 1};
 
-// 创建队列
-Queue* createQueue(int capacity) {
-    Queue* queue = (Queue*)malloc(sizeof(Queue));
-    if (!queue) return NULL;
-    
-    queue->data = (Position*)malloc(capacity * sizeof(Position));
-    if (!queue->data) {
-        free(queue);
-        return NULL;
+// 位图中某一列所在的字和位
+#define BIT_WORD(col) ((col) / BITMAP_WORD_BITS)
+#define BIT_MASK(col) ((uint64_t)1 << ((col) % BITMAP_WORD_BITS))
+
+/**
+ * 初始化BFS工作区
+ * 
+ * @param workspace 指向工作区的指针
+ */
+void initBfsWorkspace(BfsWorkspace *workspace) {
+    workspace->cells = NULL;
+    workspace->queue = NULL;
+    workspace->capacity = 0;
+    workspace->stamp = 0;
+    workspace->heap = NULL;
+    workspace->heapCapacity = 0;
+}
+
+/**
+ * 确保工作区能容纳该迷宫，容量不足时才重新分配
+ * 
+ * @param workspace 指向工作区的指针
+ * @param maze 指向迷宫结构体的指针
+ * @return 成功返回true，内存不足返回false
+ */
+bool reserveBfsWorkspace(BfsWorkspace *workspace, Maze *maze) {
+    size_t cellCount = MAZE_CELL_COUNT(maze);
+    if (cellCount <= workspace->capacity) {
+        return true;
     }
     
-    queue->front = 0;
-    queue->rear = -1;
-    queue->size = 0;
-    queue->capacity = capacity;
+    freeBfsWorkspace(workspace);
     
-    return queue;
+    // 大迷宫的工作区可达数GB，由 allocateBuffer 按需改用 mmap
+    workspace->capacity = cellCount;
+    workspace->cells = (BfsCell*)allocateBuffer(cellCount * sizeof(BfsCell));
+    workspace->queue = (CellIndex*)allocateBuffer(2 * cellCount * sizeof(CellIndex));
+    if (!workspace->cells || !workspace->queue) {
+        freeBfsWorkspace(workspace);
+        return false;
+    }
+    return true;
 }
 
-// 检查队列是否为空
-bool isEmpty(Queue* queue) {
-    return queue->size == 0;
+/**
+ * 释放BFS工作区
+ * 
+ * @param workspace 指向工作区的指针
+ */
+void freeBfsWorkspace(BfsWorkspace *workspace) {
+    releaseBuffer(workspace->cells, workspace->capacity * sizeof(BfsCell));
+    releaseBuffer(workspace->queue, 2 * workspace->capacity * sizeof(CellIndex));
+    free(workspace->heap);
+    initBfsWorkspace(workspace);
 }
 
-// 检查队列是否已满
-bool isFull(Queue* queue) {
-    return queue->size == queue->capacity;
+/**
+ * 开始一次新的搜索，预留 count 个连续的搜索编号并返回第一个
+ * 编号即将回绕时清零访问标记
+ */
+static unsigned int nextBfsStamps(BfsWorkspace *workspace, unsigned int count) {
+    if (workspace->stamp > UINT_MAX - count) {
+        memset(workspace->cells, 0, workspace->capacity * sizeof(BfsCell));
+        workspace->stamp = 0;
+    }
+    unsigned int first = workspace->stamp + 1;
+    workspace->stamp += count;
+    return first;
 }
 
-// 入队
-bool enqueue(Queue* queue, Position position) {
-    if (isFull(queue)) return false;
+/**
+ * 使用工作区执行BFS，计算两点间最短路径长度
+ * 
+ * 格子按网格缓冲区下标入队，四周的哨兵墙保证相邻下标始终有效，
+ * 因此扩展邻居时只需做偏移和比较。
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @param workspace 指向工作区的指针
+ * @param start 起点
+ * @param end 终点
+ * @return 最短路径长度，如果不可达或内存不足则返回-1
+ */
+int bfsShortestDistance(Maze *maze, BfsWorkspace *workspace, Position start, Position end) {
+    if (isOutOfBounds(maze, start.row, start.col) || isOutOfBounds(maze, end.row, end.col)) {
+        return -1;
+    }
+    if (!reserveBfsWorkspace(workspace, maze)) {
+        return -1;
+    }
     
-    queue->rear = (queue->rear + 1) % queue->capacity;
-    queue->data[queue->rear] = position;
-    queue->size++;
+    const char *grid = maze->cells;
+    const uint8_t *masks = maze->moveMasks;
+    BfsCell *cells = workspace->cells;
+    CellIndex *queue = workspace->queue;
+    const int offsets[4] = {-maze->stride, maze->stride, -1, 1};
+    unsigned int stamp = nextBfsStamps(workspace, 1);
     
-    return true;
+    CellIndex source = MAZE_INDEX(maze, start.row, start.col);
+    CellIndex target = MAZE_INDEX(maze, end.row, end.col);
+    if (!IS_OPEN_CELL(grid[source]) || !IS_OPEN_CELL(grid[target])) {
+        return -1;
+    }
+    
+    // 起点入队
+    CellIndex front = 0, rear = 0;
+    queue[rear++] = source;
+    cells[source].stamp = stamp;
+    cells[source].distance = 0;
+    
+    // BFS
+    while (front < rear) {
+        CellIndex current = queue[front++];
+        int nextDistance = cells[current].distance + 1;
+        
+        // 如果到达终点，返回最短路径长度
+        if (current == target) {
+            return cells[current].distance;
+        }
+        
+        // 只尝试可移动的方向，按位从低到高即与 Direction 枚举顺序一致
+        for (unsigned mask = masks[current]; mask; mask &= mask - 1) {
+            int i = __builtin_ctz(mask);
+            CellIndex next = current + offsets[i];
+            if (cells[next].stamp != stamp) {
+                cells[next].stamp = stamp;
+                cells[next].distance = nextDistance;
+                cells[next].move = (Direction)i;
+                queue[rear++] = next;
+            }
+        }
+    }
+    
+    return -1;
 }
 
-// 出队
-bool dequeue(Queue* queue, Position* position) {
-    if (isEmpty(queue)) return false;
+/**
+ * 双向BFS中的一侧搜索
+ */
+typedef struct {
+    unsigned int stamp;     // 本侧的访问标记
+    unsigned int other;     // 另一侧的访问标记
+    CellIndex front;        // 队首
+    CellIndex rear;         // 队尾
+    int direction;          // 队列增长方向，正向侧从数组头部向后，反向侧从尾部向前
+    CellIndex base;         // 队列在数组中的起始下标
+} BfsSide;
+
+/**
+ * 把一侧当前整层的格子向外扩展一步
+ * 
+ * 遇到另一侧已访问的格子时记录经过该处的路径长度，
+ * 整层扩展完后取其中最小值，保证结果与单向BFS一致。
+ * 
+ * @return 本层发现的最短相遇路径长度，没有相遇返回-1
+ */
+static int expandBfsLevel(const uint8_t *masks, BfsCell *cells, CellIndex *queue,
+                          const int offsets[4], BfsSide *side) {
+    int best = -1;
+    CellIndex levelEnd = side->rear;
     
-    *position = queue->data[queue->front];
-    queue->front = (queue->front + 1) % queue->capacity;
-    queue->size--;
+    while (side->front < levelEnd) {
+        CellIndex current = queue[side->base + side->direction * side->front++];
+        int nextDistance = cells[current].distance + 1;
+        
+        for (unsigned mask = masks[current]; mask; mask &= mask - 1) {
+            CellIndex next = current + offsets[__builtin_ctz(mask)];
+            if (cells[next].stamp == side->stamp) {
+                continue;
+            }
+            if (cells[next].stamp == side->other) {
+                int meet = nextDistance + cells[next].distance;
+                if (best < 0 || meet < best) {
+                    best = meet;
+                }
+                continue;
+            }
+            cells[next].stamp = side->stamp;
+            cells[next].distance = nextDistance;
+            queue[side->base + side->direction * side->rear++] = next;
+        }
+    }
     
-    return true;
+    return best;
 }
 
-// 释放队列内存
-void destroyQueue(Queue* queue) {
-    if (queue) {
-        if (queue->data) {
-            free(queue->data);
+/**
+ * 使用工作区执行双向BFS，计算两点间最短路径长度
+ * 
+ * 从起点和终点同时按层搜索，每次扩展当前层较小的一侧，
+ * 两侧相遇的那一层扩展完即停止。开阔的迷宫中访问的格子远少于单向BFS。
+ * 两侧共用工作区的一个队列，分别从数组两端向中间增长。
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @param workspace 指向工作区的指针
+ * @param start 起点
+ * @param end 终点
+ * @return 最短路径长度，如果不可达或内存不足则返回-1
+ */
+int bfsShortestDistanceBidirectional(Maze *maze, BfsWorkspace *workspace, Position start, Position end) {
+    if (isOutOfBounds(maze, start.row, start.col) || isOutOfBounds(maze, end.row, end.col)) {
+        return -1;
+    }
+    if (!reserveBfsWorkspace(workspace, maze)) {
+        return -1;
+    }
+    
+    const char *grid = maze->cells;
+    BfsCell *cells = workspace->cells;
+    CellIndex *queue = workspace->queue;
+    const int offsets[4] = {-maze->stride, maze->stride, -1, 1};
+    
+    CellIndex source = MAZE_INDEX(maze, start.row, start.col);
+    CellIndex target = MAZE_INDEX(maze, end.row, end.col);
+    if (!IS_OPEN_CELL(grid[source]) || !IS_OPEN_CELL(grid[target])) {
+        return -1;
+    }
+    if (source == target) {
+        return 0;
+    }
+    
+    unsigned int stamp = nextBfsStamps(workspace, 2);
+    BfsSide forward = {stamp, stamp + 1, 0, 0, 1, 0};
+    BfsSide backward = {stamp + 1, stamp, 0, 0, -1, (CellIndex)workspace->capacity - 1};
+    
+    // 起点和终点分别入队
+    queue[forward.base] = source;
+    forward.rear = 1;
+    cells[source].stamp = forward.stamp;
+    cells[source].distance = 0;
+    
+    queue[backward.base] = target;
+    backward.rear = 1;
+    cells[target].stamp = backward.stamp;
+    cells[target].distance = 0;
+    
+    // 任一侧没有可扩展的格子时说明不可达
+    while (forward.front < forward.rear && backward.front < backward.rear) {
+        BfsSide *side = forward.rear - forward.front <= backward.rear - backward.front
+                        ? &forward : &backward;
+        int best = expandBfsLevel(maze->moveMasks, cells, queue, offsets, side);
+        if (best >= 0) {
+            return best;
         }
-        free(queue);
     }
+    
+    return -1;
 }
 
 /**
- * 获取下一个可能的移动位置
+ * 由网格缓冲区下标求出格子位置
+ */
+static Position cellPosition(Maze *maze, CellIndex index) {
+    Position position;
+    position.row = (int)(index / maze->stride) - MAZE_PADDING;
+    position.col = (int)(index % maze->stride) - MAZE_PADDING;
+    return position;
+}
+
+/**
+ * 使用工作区执行A*搜索，计算两点间最短路径长度
+ * 
+ * 启发函数为 calculateDistance 给出的曼哈顿距离，它在四连通网格上可采纳且一致。
+ * 每走一步 g 加1、h 加1或减1，所以 f = g + h 只会不变或加2，
+ * 开放集合只需两个桶：当前 f 值的桶和 f + 2 的桶，轮流使用工作区队列的两半。
+ * 桶内按后进先出弹出，优先展开更深的格子。
  * 
  * @param maze 指向迷宫结构体的指针
- * @param current 当前位置
- * @param count 输出参数，返回可能的移动数量
- * @return 可能的移动位置数组，使用后需要释放内存
+ * @param workspace 指向工作区的指针
+ * @param start 起点
+ * @param end 终点
+ * @return 最短路径长度，与BFS相同；如果不可达或内存不足则返回-1
  */
-Position* getNextPossibleMoves(Maze *maze, Position current, int *count) {
-    // 定义上、下、左、右四个方向的偏移量
-    const int dx[4] = {-1, 1, 0, 0};
-    const int dy[4] = {0, 0, -1, 1};
+int aStarShortestDistance(Maze *maze, BfsWorkspace *workspace, Position start, Position end) {
+    if (isOutOfBounds(maze, start.row, start.col) || isOutOfBounds(maze, end.row, end.col)) {
+        return -1;
+    }
+    if (!reserveBfsWorkspace(workspace, maze)) {
+        return -1;
+    }
     
-    Position* positions = (Position*)malloc(4 * sizeof(Position));
-    if (!positions) return NULL;
+    const char *grid = maze->cells;
+    BfsCell *cells = workspace->cells;
+    const int offsets[4] = {-maze->stride, maze->stride, -1, 1};
     
-    *count = 0;
+    CellIndex source = MAZE_INDEX(maze, start.row, start.col);
+    CellIndex target = MAZE_INDEX(maze, end.row, end.col);
+    if (!IS_OPEN_CELL(grid[source]) || !IS_OPEN_CELL(grid[target])) {
+        return -1;
+    }
     
-    // 检查四个方向
-    for (int i = 0; i < 4; i++) {
-        int newRow = current.row + dx[i];
-        int newCol = current.col + dy[i];
+    // 格子在开放集合中时标记为 open，展开后标记为 closed
+    unsigned int open = nextBfsStamps(workspace, 2);
+    unsigned int closed = open + 1;
+    
+    // 两个桶各占队列的一半，每个格子在同一个桶中最多出现一次
+    CellIndex *current = workspace->queue;
+    CellIndex *later = workspace->queue + workspace->capacity;
+    CellIndex currentSize = 0, laterSize = 0;
+    
+    current[currentSize++] = source;
+    cells[source].stamp = open;
+    cells[source].distance = 0;
+    
+    while (currentSize > 0 || laterSize > 0) {
+        // 当前桶取完后转到 f + 2 的桶
+        if (currentSize == 0) {
+            CellIndex *swap = current;
+            current = later;
+            later = swap;
+            currentSize = laterSize;
+            laterSize = 0;
+        }
         
-        // 如果新位置不是墙，则添加到可能的移动列表中
-        if (!isWall(maze, newRow, newCol)) {
-            positions[*count].row = newRow;
-            positions[*count].col = newCol;
-            (*count)++;
+        CellIndex index = current[--currentSize];
+        
+        // 距离被改进过的格子会在更早的桶里先展开，这里的旧条目直接跳过
+        if (cells[index].stamp == closed) {
+            continue;
+        }
+        cells[index].stamp = closed;
+        
+        int g = cells[index].distance;
+        if (index == target) {
+            return g;
+        }
+        
+        Position position = cellPosition(maze, index);
+        int h = calculateDistance(position, end);
+        for (int i = 0; i < 4; i++) {
+            CellIndex next = index + offsets[i];
+            if (!IS_OPEN_CELL(grid[next]) || cells[next].stamp == closed) {
+                continue;
+            }
+            // 已经以不更长的距离进入开放集合的格子不再入桶
+            if (cells[next].stamp == open && cells[next].distance <= g + 1) {
+                continue;
+            }
+            cells[next].stamp = open;
+            cells[next].distance = g + 1;
+            cells[next].move = (Direction)i;
+            
+            // 朝终点走 f 不变，留在当前桶；否则 f 加2，放入下一个桶
+            Position nextPosition = {position.row + DIRECTION_ROW[i], position.col + DIRECTION_COL[i]};
+            if (calculateDistance(nextPosition, end) < h) {
+                current[currentSize++] = next;
+            } else {
+                later[laterSize++] = next;
+            }
         }
     }
     
-    return positions;
+    return -1;
 }
 
 /**
- * 使用BFS算法检查终点是否可达
+ * 使用A*计算从起点到终点的最短路径长度
  * 
  * @param maze 指向迷宫结构体的指针
- * @return 可达返回true，否则返回false
+ * @return 最短路径长度，如果不可达则返回-1
  */
-bool isReachable(Maze *maze) {
-    // 创建访问标记数组
-    bool** visited = (bool**)malloc(maze->height * sizeof(bool*));
-    if (!visited) return false;
-    
-    for (int i = 0; i < maze->height; i++) {
-        visited[i] = (bool*)malloc(maze->width * sizeof(bool));
-        if (!visited[i]) {
-            // 释放已分配的内存
-            for (int j = 0; j < i; j++) {
-                free(visited[j]);
-            }
-            free(visited);
+int calculateShortestPathLengthAStar(Maze *maze) {
+    BfsWorkspace workspace;
+    initBfsWorkspace(&workspace);
+    
+    int shortestPath = aStarShortestDistance(maze, &workspace, maze->start, maze->exit);
+    
+    freeBfsWorkspace(&workspace);
+    return shortestPath;
+}
+
+/**
+ * 向二叉堆压入一个条目，容量不足时倍增
+ * 
+ * @return 成功返回true，内存不足返回false
+ */
+static bool pushSearchHeap(BfsWorkspace *workspace, size_t *size, int estimate, CellIndex index) {
+    if (*size == workspace->heapCapacity) {
+        size_t capacity = workspace->heapCapacity ? workspace->heapCapacity * 2 : 256;
+        SearchHeapEntry *heap = (SearchHeapEntry*)realloc(workspace->heap, capacity * sizeof(SearchHeapEntry));
+        if (!heap) {
             return false;
         }
-        memset(visited[i], false, maze->width * sizeof(bool));
+        workspace->heap = heap;
+        workspace->heapCapacity = capacity;
     }
     
-    // 创建队列
-    Queue* queue = createQueue(maze->width * maze->height);
-    if (!queue) {
-        // 释放访问标记数组
-        for (int i = 0; i < maze->height; i++) {
-            free(visited[i]);
+    SearchHeapEntry *heap = workspace->heap;
+    size_t child = (*size)++;
+    while (child > 0) {
+        size_t parent = (child - 1) / 2;
+        if (heap[parent].estimate <= estimate) {
+            break;
         }
-        free(visited);
-        return false;
+        heap[child] = heap[parent];
+        child = parent;
     }
+    heap[child].estimate = estimate;
+    heap[child].index = index;
+    return true;
+}
+
+/**
+ * 弹出二叉堆中估计值最小的条目
+ */
+static SearchHeapEntry popSearchHeap(BfsWorkspace *workspace, size_t *size) {
+    SearchHeapEntry *heap = workspace->heap;
+    SearchHeapEntry top = heap[0];
+    SearchHeapEntry last = heap[--(*size)];
     
-    // 起点入队
-    enqueue(queue, maze->start);
-    visited[maze->start.row][maze->start.col] = true;
+    size_t parent = 0;
+    for (;;) {
+        size_t child = parent * 2 + 1;
+        if (child >= *size) {
+            break;
+        }
+        if (child + 1 < *size && heap[child + 1].estimate < heap[child].estimate) {
+            child++;
+        }
+        if (last.estimate <= heap[child].estimate) {
+            break;
+        }
+        heap[parent] = heap[child];
+        parent = child;
+    }
+    if (*size > 0) {
+        heap[parent] = last;
+    }
+    return top;
+}
+
+/**
+ * 沿水平方向跳跃，直到遇到终点或有强制邻居的格子
+ * 
+ * 跳点搜索约定规范路径先竖直后水平，所以水平移动中只有当某个竖直邻居
+ * 无法从上一格先竖直走到时（上一格的同侧格子是墙），才需要在这里转向。
+ * 
+ * @return 跳点的下标，撞墙前没有跳点返回-1
+ */
+static CellIndex jumpHorizontal(const char *grid, int stride, CellIndex from, int step, CellIndex target) {
+    CellIndex current = from;
+    for (;;) {
+        CellIndex next = current + step;
+        if (!IS_OPEN_CELL(grid[next])) {
+            return -1;
+        }
+        if (next == target) {
+            return next;
+        }
+        if ((IS_OPEN_CELL(grid[next - stride]) && !IS_OPEN_CELL(grid[current - stride])) ||
+            (IS_OPEN_CELL(grid[next + stride]) && !IS_OPEN_CELL(grid[current + stride]))) {
+            return next;
+        }
+        current = next;
+    }
+}
+
+/**
+ * 沿竖直方向跳跃，每走一格都向左右两侧做水平跳跃，
+ * 任一侧能找到跳点时当前格子就是跳点
+ * 
+ * @return 跳点的下标，撞墙前没有跳点返回-1
+ */
+static CellIndex jumpVertical(const char *grid, int stride, CellIndex from, int step, CellIndex target) {
+    CellIndex current = from;
+    for (;;) {
+        CellIndex next = current + step;
+        if (!IS_OPEN_CELL(grid[next])) {
+            return -1;
+        }
+        if (next == target ||
+            jumpHorizontal(grid, stride, next, -1, target) >= 0 ||
+            jumpHorizontal(grid, stride, next, 1, target) >= 0) {
+            return next;
+        }
+        current = next;
+    }
+}
+
+/**
+ * 跳点搜索的主体，搜索结束后终点的 distance/move 可用于回溯路径
+ * 
+ * @return 最短路径长度，如果不可达或内存不足则返回-1
+ */
+static int runJumpPointSearch(Maze *maze, BfsWorkspace *workspace, Position start, Position end) {
+    if (isOutOfBounds(maze, start.row, start.col) || isOutOfBounds(maze, end.row, end.col)) {
+        return -1;
+    }
+    if (!reserveBfsWorkspace(workspace, maze)) {
+        return -1;
+    }
     
-    bool reachable = false;
+    const char *grid = maze->cells;
+    BfsCell *cells = workspace->cells;
+    int stride = maze->stride;
+    const int offsets[4] = {-stride, stride, -1, 1};
     
-    // BFS
-    while (!isEmpty(queue)) {
-        Position current;
-        dequeue(queue, &current);
+    CellIndex source = MAZE_INDEX(maze, start.row, start.col);
+    CellIndex target = MAZE_INDEX(maze, end.row, end.col);
+    if (!IS_OPEN_CELL(grid[source]) || !IS_OPEN_CELL(grid[target])) {
+        return -1;
+    }
+    
+    unsigned int open = nextBfsStamps(workspace, 2);
+    unsigned int closed = open + 1;
+    size_t heapSize = 0;
+    
+    cells[source].stamp = open;
+    cells[source].distance = 0;
+    if (!pushSearchHeap(workspace, &heapSize, calculateDistance(start, end), source)) {
+        return -1;
+    }
+    
+    while (heapSize > 0) {
+        SearchHeapEntry entry = popSearchHeap(workspace, &heapSize);
+        CellIndex index = entry.index;
+        if (cells[index].stamp == closed) {
+            continue;
+        }
+        cells[index].stamp = closed;
         
-        // 如果到达终点，则可达
-        if (isSamePosition(current, maze->exit)) {
-            reachable = true;
-            break;
+        int g = cells[index].distance;
+        if (index == target) {
+            return g;
         }
         
-        // 尝试四个方向
-        int count;
-        Position* nextMoves = getNextPossibleMoves(maze, current, &count);
+        // 剪枝后的邻居方向：起点四个方向都走；竖直到达的格子继续竖直并向两侧展开；
+        // 水平到达的格子继续水平，只在有强制邻居时转向竖直
+        bool directions[4] = {true, true, true, true};
+        if (index != source) {
+            Direction move = cells[index].move;
+            if (move == UP || move == DOWN) {
+                directions[move == UP ? DOWN : UP] = false;
+            } else {
+                CellIndex behind = index - offsets[move];
+                directions[move == LEFT ? RIGHT : LEFT] = false;
+                directions[UP] = IS_OPEN_CELL(grid[index - stride]) && !IS_OPEN_CELL(grid[behind - stride]);
+                directions[DOWN] = IS_OPEN_CELL(grid[index + stride]) && !IS_OPEN_CELL(grid[behind + stride]);
+            }
+        }
         
-        for (int i = 0; i < count; i++) {
-            int nextRow = nextMoves[i].row;
-            int nextCol = nextMoves[i].col;
+        for (int i = 0; i < 4; i++) {
+            if (!directions[i]) {
+                continue;
+            }
+            CellIndex jump = (i == UP || i == DOWN)
+                             ? jumpVertical(grid, stride, index, offsets[i], target)
+                             : jumpHorizontal(grid, stride, index, offsets[i], target);
+            if (jump < 0 || cells[jump].stamp == closed) {
+                continue;
+            }
             
-            // 如果未访问过，则入队
-            if (!visited[nextRow][nextCol]) {
-                visited[nextRow][nextCol] = true;
-                Position next = {nextRow, nextCol};
-                enqueue(queue, next);
+            Position jumpPosition = cellPosition(maze, jump);
+            int distance = g + (int)((jump - index) / offsets[i]);
+            if (cells[jump].stamp == open && cells[jump].distance <= distance) {
+                continue;
+            }
+            cells[jump].stamp = open;
+            cells[jump].distance = distance;
+            cells[jump].move = (Direction)i;
+            if (!pushSearchHeap(workspace, &heapSize, distance + calculateDistance(jumpPosition, end), jump)) {
+                return -1;
             }
         }
-        
-        free(nextMoves);
-    }
-    
-    // 释放内存
-    destroyQueue(queue);
-    for (int i = 0; i < maze->height; i++) {
-        free(visited[i]);
     }
-    free(visited);
     
-    return reachable;
+    return -1;
 }
 
 /**
- * 检查迷宫是否有解
+ * 使用工作区执行跳点搜索（四连通版本），计算两点间最短路径长度
+ * 
+ * 在代价一致的四连通网格上，沿直线通道逐格入队是对称路径造成的浪费。
+ * 跳点搜索只把终点、有强制邻居的格子以及能横向找到跳点的竖直格子放入开放集合，
+ * 再用以曼哈顿距离为启发函数的A*在跳点之间搜索，结果与BFS相同。
  * 
  * @param maze 指向迷宫结构体的指针
- * @return 有解返回true，否则返回false
+ * @param workspace 指向工作区的指针
+ * @param start 起点
+ * @param end 终点
+ * @return 最短路径长度，如果不可达或内存不足则返回-1
  */
-bool isMazeSolvable(Maze *maze) {
-    return isReachable(maze);
+int jumpPointShortestDistance(Maze *maze, BfsWorkspace *workspace, Position start, Position end) {
+    return runJumpPointSearch(maze, workspace, start, end);
 }
 
 /**
- * 计算从起点到终点的最短路径长度
+ * 使用跳点搜索寻找最短路径
+ * 
+ * 每个跳点记录到达它的直线方向，回溯时沿该方向倒退，
+ * 直到遇到距离恰好吻合的已到达格子，把中间每一步展开为 w/s/a/d 命令。
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @param workspace 可复用的工作区
+ * @param start 起点
+ * @param end 终点
+ * @param path 接收结果的路径，命令缓冲区由调用者提供
+ * @return 找到路径并写入缓冲区返回true，否则返回false
+ */
+bool findShortestPathJumpPoint(Maze *maze, BfsWorkspace *workspace, Position start, Position end, MazePath *path) {
+    path->start = start;
+    path->length = runJumpPointSearch(maze, workspace, start, end);
+    if (path->length < 0 || path->length > path->capacity) {
+        return false;
+    }
+    
+    const BfsCell *cells = workspace->cells;
+    const int offsets[4] = {-maze->stride, maze->stride, -1, 1};
+    unsigned int open = workspace->stamp - 1;
+    unsigned int closed = workspace->stamp;
+    CellIndex current = MAZE_INDEX(maze, end.row, end.col);
+    int step = path->length;
+    
+    // step 始终等于当前格子的距离，也就是下一条要写入的命令之后的位置
+    while (step > 0) {
+        Direction move = cells[current].move;
+        
+        // 沿直线倒退到上一个跳点
+        do {
+            path->commands[--step] = DIRECTION_COMMANDS[move];
+            current -= offsets[move];
+        } while ((cells[current].stamp != open && cells[current].stamp != closed) ||
+                 cells[current].distance != step);
+    }
+    
+    return true;
+}
+
+/**
+ * 使用跳点搜索计算从起点到终点的最短路径长度
  * 
  * @param maze 指向迷宫结构体的指针
  * @return 最短路径长度，如果不可达则返回-1
  */
-int calculateShortestPathLength(Maze *maze) {
-    // 创建访问标记数组和距离数组
-    bool** visited = (bool**)malloc(maze->height * sizeof(bool*));
-    int** distance = (int**)malloc(maze->height * sizeof(int*));
+int calculateShortestPathLengthJumpPoint(Maze *maze) {
+    BfsWorkspace workspace;
+    initBfsWorkspace(&workspace);
     
-    if (!visited || !distance) return -1;
+    int shortestPath = jumpPointShortestDistance(maze, &workspace, maze->start, maze->exit);
     
-    for (int i = 0; i < maze->height; i++) {
-        visited[i] = (bool*)malloc(maze->width * sizeof(bool));
-        distance[i] = (int*)malloc(maze->width * sizeof(int));
+    freeBfsWorkspace(&workspace);
+    return shortestPath;
+}
+
+/**
+ * 在字内把已到达的位沿可通行的连续段向高位扩散
+ * 使用对数步长的前缀传播，6步覆盖64位
+ */
+static uint64_t spreadUp(uint64_t reach, uint64_t open) {
+    reach &= open;
+    for (int shift = 1; shift < BITMAP_WORD_BITS; shift <<= 1) {
+        reach |= open & (reach << shift);
+        open &= open << shift;
+    }
+    return reach;
+}
+
+/**
+ * 在字内把已到达的位沿可通行的连续段向低位扩散
+ */
+static uint64_t spreadDown(uint64_t reach, uint64_t open) {
+    reach &= open;
+    for (int shift = 1; shift < BITMAP_WORD_BITS; shift <<= 1) {
+        reach |= open & (reach >> shift);
+        open &= open >> shift;
+    }
+    return reach;
+}
+
+/**
+ * 在一行内把已到达的格子填满它们所在的整段通道
+ * 
+ * 先由低到高扩散并把最高位进位到下一个字，再由高到低扩散，
+ * 两遍之后每段含有已到达格子的通道都被完整填满。
+ * 
+ * @param reach 该行的到达位图
+ * @param walls 该行的墙位图
+ * @param words 该行的字数
+ */
+static void fillRow(uint64_t *reach, const uint64_t *walls, int words) {
+    uint64_t carry = 0;
+    for (int w = 0; w < words; w++) {
+        reach[w] = spreadUp(reach[w] | carry, ~walls[w]);
+        carry = reach[w] >> (BITMAP_WORD_BITS - 1);
+    }
+    
+    carry = 0;
+    for (int w = words - 1; w >= 0; w--) {
+        reach[w] = spreadDown(reach[w] | (carry << (BITMAP_WORD_BITS - 1)), ~walls[w]);
+        carry = reach[w] & 1;
+    }
+}
+
+/**
+ * 把相邻行已到达的格子向本行传播，并在本行内填满通道
+ * 
+ * @return 本行有新到达的格子返回true
+ */
+static bool spreadFromRow(uint64_t *reach, const uint64_t *neighbor, const uint64_t *walls, int words) {
+    bool changed = false;
+    for (int w = 0; w < words; w++) {
+        uint64_t added = neighbor[w] & ~walls[w] & ~reach[w];
+        if (added) {
+            reach[w] |= added;
+            changed = true;
+        }
+    }
+    if (changed) {
+        fillRow(reach, walls, words);
+    }
+    return changed;
+}
+
+/**
+ * 在墙位图上检查终点是否可达
+ * 
+ * 每格只占1位，行内用按字并行的移位掩码一次填满整段通道，
+ * 再自上而下、自下而上交替向相邻行传播，直到没有新格子或到达终点。
+ * 开阔的迷宫只需很少几轮；曲折的迷宫轮数会增加，此时 isReachable 更合适。
+ * 
+ * @param maze 指向迷宫结构体的指针，需已生成墙位图
+ * @return 可达返回true，否则返回false
+ */
+bool isReachableBitmap(Maze *maze) {
+    int words = maze->wallWordsPerRow;
+    size_t totalWords = WALL_BITMAP_WORDS(maze);
+    uint64_t *reach = (uint64_t*)allocateBuffer(totalWords * sizeof(uint64_t));
+    if (!reach) {
+        return false;
+    }
+    
+    const uint64_t *walls = maze->wallBits;
+    uint64_t *exitWord = reach + (size_t)maze->exit.row * words + BIT_WORD(maze->exit.col);
+    uint64_t exitMask = BIT_MASK(maze->exit.col);
+    
+    // 从起点所在的整段通道开始
+    uint64_t *startRow = reach + (size_t)maze->start.row * words;
+    startRow[BIT_WORD(maze->start.col)] |= BIT_MASK(maze->start.col);
+    fillRow(startRow, walls + (size_t)maze->start.row * words, words);
+    
+    bool changed = true;
+    while (changed && !(*exitWord & exitMask)) {
+        changed = false;
         
-        if (!visited[i] || !distance[i]) {
-            // 释放已分配的内存
-            for (int j = 0; j < i; j++) {
-                if (visited[j]) free(visited[j]);
-                if (distance[j]) free(distance[j]);
-            }
-            if (visited) free(visited);
-            if (distance) free(distance);
-            return -1;
+        // 自上而下传播
+        for (int i = 1; i < maze->height; i++) {
+            size_t row = (size_t)i * words;
+            changed |= spreadFromRow(reach + row, reach + row - words, walls + row, words);
         }
         
-        memset(visited[i], false, maze->width * sizeof(bool));
-        memset(distance[i], 0, maze->width * sizeof(int));
+        // 自下而上传播
+        for (int i = maze->height - 2; i >= 0; i--) {
+            size_t row = (size_t)i * words;
+            changed |= spreadFromRow(reach + row, reach + row + words, walls + row, words);
+        }
     }
     
-    // 创建队列
-    Queue* queue = createQueue(maze->width * maze->height);
-    if (!queue) {
-        // 释放内存
-        for (int i = 0; i < maze->height; i++) {
-            free(visited[i]);
-            free(distance[i]);
-        }
-        free(visited);
-        free(distance);
+    bool reachable = (*exitWord & exitMask) != 0;
+    releaseBuffer(reach, totalWords * sizeof(uint64_t));
+    return reachable;
+}
+
+/**
+ * 在墙位图上按层推进的BFS，计算两点间最短路径长度
+ * 
+ * 当前层、已访问集合和下一层都是位图，每一层用移位和掩码
+ * 一次扩展一个字内的64个格子，只处理当前层所在的行区间。
+ * 
+ * @param maze 指向迷宫结构体的指针，需已生成墙位图
+ * @param start 起点
+ * @param end 终点
+ * @return 最短路径长度，如果不可达或内存不足则返回-1
+ */
+int bfsShortestDistanceBitmap(Maze *maze, Position start, Position end) {
+    if (isOutOfBounds(maze, start.row, start.col) || isOutOfBounds(maze, end.row, end.col) ||
+        isWall(maze, start.row, start.col) || isWall(maze, end.row, end.col)) {
         return -1;
     }
     
-    // 起点入队
-    enqueue(queue, maze->start);
-    visited[maze->start.row][maze->start.col] = true;
-    distance[maze->start.row][maze->start.col] = 0;
+    int words = maze->wallWordsPerRow;
+    size_t totalWords = WALL_BITMAP_WORDS(maze);
+    uint64_t *buffer = (uint64_t*)allocateBuffer(3 * totalWords * sizeof(uint64_t));
+    if (!buffer) {
+        return -1;
+    }
     
-    int shortestPath = -1;
+    const uint64_t *walls = maze->wallBits;
+    uint64_t *visited = buffer;
+    uint64_t *frontier = buffer + totalWords;
+    uint64_t *next = buffer + 2 * totalWords;
     
-    // BFS
-    while (!isEmpty(queue)) {
-        Position current;
-        dequeue(queue, &current);
-        
-        // 如果到达终点，记录最短路径长度
-        if (isSamePosition(current, maze->exit)) {
-            shortestPath = distance[current.row][current.col];
+    size_t startWord = (size_t)start.row * words + BIT_WORD(start.col);
+    size_t endWord = (size_t)end.row * words + BIT_WORD(end.col);
+    uint64_t endMask = BIT_MASK(end.col);
+    frontier[startWord] = visited[startWord] = BIT_MASK(start.col);
+    
+    // 当前层所在的行区间，以及 next 缓冲区里残留的上上层的行区间
+    int low = start.row, high = start.row;
+    int staleLow = 0, staleHigh = -1;
+    int distance = 0;
+    int result = -1;
+    
+    while (low <= high) {
+        if (frontier[endWord] & endMask) {
+            result = distance;
             break;
         }
         
-        // 尝试四个方向
-        int count;
-        Position* nextMoves = getNextPossibleMoves(maze, current, &count);
+        // 清掉 next 中上上层留下的内容
+        if (staleLow <= staleHigh) {
+            memset(next + (size_t)staleLow * words, 0,
+                   (size_t)(staleHigh - staleLow + 1) * words * sizeof(uint64_t));
+        }
         
-        for (int i = 0; i < count; i++) {
-            int nextRow = nextMoves[i].row;
-            int nextCol = nextMoves[i].col;
+        int nextLow = low > 0 ? low - 1 : 0;
+        int nextHigh = high < maze->height - 1 ? high + 1 : maze->height - 1;
+        int foundLow = maze->height, foundHigh = -1;
+        
+        for (int i = nextLow; i <= nextHigh; i++) {
+            const uint64_t *row = frontier + (size_t)i * words;
+            const uint64_t *above = i > 0 ? row - words : NULL;
+            const uint64_t *below = i < maze->height - 1 ? row + words : NULL;
+            size_t offset = (size_t)i * words;
+            bool any = false;
+            
+            for (int w = 0; w < words; w++) {
+                // 左右相邻格子，跨字的位从相邻字借入
+                uint64_t spread = (row[w] << 1) | (row[w] >> 1);
+                if (w > 0) spread |= row[w - 1] >> (BITMAP_WORD_BITS - 1);
+                if (w < words - 1) spread |= row[w + 1] << (BITMAP_WORD_BITS - 1);
+                
+                // 上下相邻格子
+                if (above && i - 1 >= low) spread |= above[w];
+                if (below && i + 1 <= high) spread |= below[w];
+                
+                uint64_t added = spread & ~walls[offset + w] & ~visited[offset + w];
+                next[offset + w] = added;
+                visited[offset + w] |= added;
+                any |= added != 0;
+            }
             
-            // 如果未访问过，则入队
-            if (!visited[nextRow][nextCol]) {
-                visited[nextRow][nextCol] = true;
-                distance[nextRow][nextCol] = distance[current.row][current.col] + 1;
-                Position next = {nextRow, nextCol};
-                enqueue(queue, next);
+            if (any) {
+                if (i < foundLow) foundLow = i;
+                foundHigh = i;
             }
         }
         
-        free(nextMoves);
+        // next 成为新的当前层，旧的当前层留待下一轮清除
+        uint64_t *swap = frontier;
+        frontier = next;
+        next = swap;
+        staleLow = low;
+        staleHigh = high;
+        low = foundLow;
+        high = foundHigh;
+        distance++;
     }
     
-    // 释放内存
-    destroyQueue(queue);
-    for (int i = 0; i < maze->height; i++) {
-        free(visited[i]);
-        free(distance[i]);
+    releaseBuffer(buffer, 3 * totalWords * sizeof(uint64_t));
+    return result;
+}
+
+/**
+ * 在墙位图上计算从起点到终点的最短路径长度
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @return 最短路径长度，如果不可达则返回-1
+ */
+int calculateShortestPathLengthBitmap(Maze *maze) {
+    return bfsShortestDistanceBitmap(maze, maze->start, maze->exit);
+}
+
+/**
+ * 获取下一个可能的移动位置
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @param current 当前位置
+ * @param count 输出参数，返回可能的移动数量
+ * @return 可能的移动位置数组，使用后需要释放内存
+ */
+Position* getNextPossibleMoves(Maze *maze, Position current, int *count) {
+    Position* positions = (Position*)malloc(4 * sizeof(Position));
+    if (!positions) return NULL;
+    
+    *count = 0;
+    
+    // 网格四周有哨兵，相邻格子直接按行跨度偏移访问，无需边界检查
+    const char* cell = &MAZE_CELL(maze, current.row, current.col);
+    
+    // 检查四个方向
+    for (int i = 0; i < 4; i++) {
+        // 如果新位置不是墙，则添加到可能的移动列表中
+        if (IS_OPEN_CELL(cell[DIRECTION_ROW[i] * maze->stride + DIRECTION_COL[i]])) {
+            positions[*count].row = current.row + DIRECTION_ROW[i];
+            positions[*count].col = current.col + DIRECTION_COL[i];
+            (*count)++;
+        }
     }
-    free(visited);
-    free(distance);
     
+    return positions;
+}
+
+/**
+ * 使用BFS算法检查终点是否可达
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @return 可达返回true，否则返回false
+ */
+bool isReachable(Maze *maze) {
+    BfsWorkspace workspace;
+    initBfsWorkspace(&workspace);
+    
+    bool reachable = isReachableWith(maze, &workspace, BFS_FORWARD);
+    
+    freeBfsWorkspace(&workspace);
+    return reachable;
+}
+
+/**
+ * 使用调用者提供的工作区按指定方式检查终点是否可达
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @param workspace 可复用的BFS工作区
+ * @param mode 单向或双向搜索
+ * @return 可达返回true，否则返回false
+ */
+bool isReachableWith(Maze *maze, BfsWorkspace *workspace, BfsMode mode) {
+    return calculateShortestPathLengthWith(maze, workspace, mode) >= 0;
+}
+
+/**
+ * 将方向转换为移动命令
+ * 
+ * @param dir 移动方向
+ * @return 对应的 w/s/a/d 命令字符
+ */
+char directionToCommand(Direction dir) {
+    return DIRECTION_COMMANDS[dir];
+}
+
+/**
+ * 初始化路径结果
+ * 
+ * @param path 指向路径结果的指针
+ * @param commands 调用者提供的命令缓冲区
+ * @param capacity 缓冲区能容纳的步数
+ */
+void initMazePath(MazePath *path, char *commands, int capacity) {
+    path->start.row = -1;
+    path->start.col = -1;
+    path->commands = commands;
+    path->capacity = capacity;
+    path->length = -1;
+}
+
+/**
+ * 使用BFS算法寻找两点间的最短路径
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @param start 起点
+ * @param end 终点
+ * @param path 接收结果的路径，命令缓冲区由调用者提供
+ * @return 找到路径并写入缓冲区返回true，否则返回false
+ */
+bool findShortestPath(Maze *maze, Position start, Position end, MazePath *path) {
+    BfsWorkspace workspace;
+    initBfsWorkspace(&workspace);
+    
+    bool found = findShortestPathWith(maze, &workspace, start, end, path);
+    
+    freeBfsWorkspace(&workspace);
+    return found;
+}
+
+/**
+ * 使用调用者提供的工作区寻找两点间的最短路径
+ * 
+ * BFS记录每个格子的来向，到达终点后沿来向回溯，
+ * 从缓冲区末尾往前写出命令。
+ * 如果缓冲区不够，path->length 仍会给出所需步数。
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @param workspace 可复用的BFS工作区
+ * @param start 起点
+ * @param end 终点
+ * @param path 接收结果的路径，命令缓冲区由调用者提供
+ * @return 找到路径并写入缓冲区返回true，否则返回false
+ */
+bool findShortestPathWith(Maze *maze, BfsWorkspace *workspace, Position start, Position end, MazePath *path) {
+    path->start = start;
+    path->length = bfsShortestDistance(maze, workspace, start, end);
+    if (path->length < 0 || path->length > path->capacity) {
+        return false;
+    }
+    
+    const int offsets[4] = {-maze->stride, maze->stride, -1, 1};
+    CellIndex current = MAZE_INDEX(maze, end.row, end.col);
+    
+    // 从终点沿来向回溯到起点
+    for (int step = path->length - 1; step >= 0; step--) {
+        Direction move = workspace->cells[current].move;
+        path->commands[step] = DIRECTION_COMMANDS[move];
+        current -= offsets[move];
+    }
+    
+    return true;
+}
+
+/**
+ * 初始化路径迭代器
+ * 
+ * @param iterator 指向迭代器的指针
+ * @param path 要遍历的路径
+ */
+void initPathIterator(PathIterator *iterator, const MazePath *path) {
+    iterator->path = path;
+    iterator->current = path->start;
+    iterator->step = 0;
+}
+
+/**
+ * 取出路径的下一步
+ * 
+ * @param iterator 指向迭代器的指针
+ * @param position 输出参数，这一步到达的位置，可为NULL
+ * @param command 输出参数，这一步的移动命令，可为NULL
+ * @return 还有下一步返回true，路径已走完返回false
+ */
+bool nextPathStep(PathIterator *iterator, Position *position, char *command) {
+    if (iterator->step >= iterator->path->length) {
+        return false;
+    }
+    
+    char c = iterator->path->commands[iterator->step++];
+    for (int i = 0; i < 4; i++) {
+        if (DIRECTION_COMMANDS[i] == c) {
+            iterator->current.row += DIRECTION_ROW[i];
+            iterator->current.col += DIRECTION_COL[i];
+            break;
+        }
+    }
+    
+    if (position) {
+        *position = iterator->current;
+    }
+    if (command) {
+        *command = c;
+    }
+    return true;
+}
+
+/**
+ * 检查迷宫是否有解
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @return 有解返回true，否则返回false
+ */
+bool isMazeSolvable(Maze *maze) {
+    return isReachable(maze);
+}
+
+/**
+ * 计算从起点到终点的最短路径长度
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @return 最短路径长度，如果不可达则返回-1
+ */
+int calculateShortestPathLength(Maze *maze) {
+    BfsWorkspace workspace;
+    initBfsWorkspace(&workspace);
+    
+    int shortestPath = calculateShortestPathLengthWith(maze, &workspace, BFS_FORWARD);
+    
+    freeBfsWorkspace(&workspace);
     return shortestPath;
-} 
\ No newline at end of file
+}
+
+/**
+ * 使用调用者提供的工作区按指定方式计算从起点到终点的最短路径长度
+ * 
+ * @param maze 指向迷宫结构体的指针
+ * @param workspace 可复用的BFS工作区
+ * @param mode 单向或双向搜索，两者结果相同
+ * @return 最短路径长度，如果不可达则返回-1
+ */
+int calculateShortestPathLengthWith(Maze *maze, BfsWorkspace *workspace, BfsMode mode) {
+    if (mode == BFS_BIDIRECTIONAL) {
+        return bfsShortestDistanceBidirectional(maze, workspace, maze->start, maze->exit);
+    }
+    return bfsShortestDistance(maze, workspace, maze->start, maze->exit);
+}
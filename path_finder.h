@@ -4,11 +4,105 @@
 #include <stdbool.h>
 #include "maze.h"
 
+// BFS中每个格子的搜索状态
+typedef struct {
+    unsigned int stamp; // 最近一次访问该格子的搜索编号
+    int distance;       // 从起点到该格子的步数
+    Direction move;     // 到达该格子时走的方向，用于回溯路径
+} BfsCell;
+
+// 优先队列中的条目
+typedef struct {
+    int estimate;           // 估计的总路径长度 f = g + h
+    CellIndex index;        // 格子下标
+} SearchHeapEntry;
+
+// BFS工作区，由调用者持有并在多次搜索间复用
+// 容量足够时搜索过程不进行任何堆分配
+typedef struct {
+    BfsCell* cells;         // 与迷宫网格缓冲区一一对应的搜索状态
+    CellIndex* queue;       // 格子下标队列，长度为格子数的两倍（A*的两个桶各用一半）
+    size_t capacity;        // 已分配的格子数
+    unsigned int stamp;     // 当前搜索编号，用于免清零地判断是否访问过
+    SearchHeapEntry* heap;  // 跳点搜索使用的二叉堆，按需倍增并在多次搜索间保留
+    size_t heapCapacity;    // 二叉堆已分配的条目数
+} BfsWorkspace;
+
+// BFS搜索方式
+typedef enum {
+    BFS_FORWARD,        // 只从起点向外搜索
+    BFS_BIDIRECTIONAL   // 同时从起点和终点搜索，两侧相遇即停止
+} BfsMode;
+
+// 最短路径结果，命令缓冲区由调用者提供
+// 每一步只保存一个 w/a/s/d 字符，格子位置由迭代器从起点推算
+typedef struct {
+    Position start;     // 路径起点
+    char* commands;     // 移动命令缓冲区
+    int capacity;       // 缓冲区能容纳的步数
+    int length;         // 路径步数
+} MazePath;
+
+// 路径迭代器，依次给出每一步的命令和到达的位置
+typedef struct {
+    const MazePath* path;
+    Position current;   // 当前所在位置
+    int step;           // 已走过的步数
+} PathIterator;
+
+// 初始化BFS工作区
+void initBfsWorkspace(BfsWorkspace *workspace);
+
+// 确保工作区能容纳该迷宫
+bool reserveBfsWorkspace(BfsWorkspace *workspace, Maze *maze);
+
+// 释放BFS工作区
+void freeBfsWorkspace(BfsWorkspace *workspace);
+
+// 使用工作区执行BFS，返回两点间最短路径长度
+int bfsShortestDistance(Maze *maze, BfsWorkspace *workspace, Position start, Position end);
+
+// 使用工作区执行双向BFS，返回两点间最短路径长度
+int bfsShortestDistanceBidirectional(Maze *maze, BfsWorkspace *workspace, Position start, Position end);
+
+// 使用工作区执行A*搜索，返回两点间最短路径长度
+int aStarShortestDistance(Maze *maze, BfsWorkspace *workspace, Position start, Position end);
+
+// 使用A*计算从起点到终点的最短路径长度
+int calculateShortestPathLengthAStar(Maze *maze);
+
+// 使用工作区执行跳点搜索，返回两点间最短路径长度
+int jumpPointShortestDistance(Maze *maze, BfsWorkspace *workspace, Position start, Position end);
+
+// 使用跳点搜索寻找最短路径，结果写入调用者提供的缓冲区
+bool findShortestPathJumpPoint(Maze *maze, BfsWorkspace *workspace, Position start, Position end, MazePath *path);
+
+// 使用跳点搜索计算从起点到终点的最短路径长度
+int calculateShortestPathLengthJumpPoint(Maze *maze);
+
 // 检查终点是否可达
 bool isReachable(Maze *maze);
 
-// 使用BFS算法寻找最短路径
-bool findShortestPath(Maze *maze, Position start, Position end);
+// 使用工作区按指定方式检查终点是否可达
+bool isReachableWith(Maze *maze, BfsWorkspace *workspace, BfsMode mode);
+
+// 使用BFS算法寻找最短路径，结果写入调用者提供的缓冲区
+bool findShortestPath(Maze *maze, Position start, Position end, MazePath *path);
+
+// 使用工作区寻找最短路径
+bool findShortestPathWith(Maze *maze, BfsWorkspace *workspace, Position start, Position end, MazePath *path);
+
+// 初始化路径结果
+void initMazePath(MazePath *path, char *commands, int capacity);
+
+// 初始化路径迭代器
+void initPathIterator(PathIterator *iterator, const MazePath *path);
+
+// 取出路径的下一步
+bool nextPathStep(PathIterator *iterator, Position *position, char *command);
+
+// 将方向转换为移动命令
+char directionToCommand(Direction dir);
 
 // 检查迷宫是否有解
 bool isMazeSolvable(Maze *maze);
@@ -16,10 +110,22 @@ bool isMazeSolvable(Maze *maze);
 // 计算从起点到终点的最短路径长度
 int calculateShortestPathLength(Maze *maze);
 
+// 使用工作区按指定方式计算从起点到终点的最短路径长度
+int calculateShortestPathLengthWith(Maze *maze, BfsWorkspace *workspace, BfsMode mode);
+
+// 在墙位图上用按字并行的泛洪填充检查终点是否可达
+bool isReachableBitmap(Maze *maze);
+
+// 在墙位图上按层推进的BFS，返回两点间最短路径长度
+int bfsShortestDistanceBitmap(Maze *maze, Position start, Position end);
+
+// 在墙位图上计算从起点到终点的最短路径长度
+int calculateShortestPathLengthBitmap(Maze *maze);
+
 // 获取下一个可能的移动位置
 Position* getNextPossibleMoves(Maze *maze, Position current, int *count);
 
 // 检查两个位置是否相同
 bool isSamePosition(Position p1, Position p2);
 
-#endif /* PATH_FINDER_H */ 
\ No newline at end of file
+#endif /* PATH_FINDER_H */
@@ -0,0 +1,347 @@
+#include "replay.h"
+#include "input_validator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// x86 上用 AVX2 收集指令批量查墙位图，运行时检测CPU是否支持
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define REPLAY_HAVE_AVX2 1
+#endif
+
+// 命令字符对应的移动：0 表示不移动，否则为方向 + 1
+static const unsigned char COMMAND_MOVE[256] = {
+    ['w'] = UP + 1,    ['W'] = UP + 1,
+    ['s'] = DOWN + 1,  ['S'] = DOWN + 1,
+    ['a'] = LEFT + 1,  ['A'] = LEFT + 1,
+    ['d'] = RIGHT + 1, ['D'] = RIGHT + 1
+};
+
+/**
+ * 从指定位置回放命令缓冲区
+ *
+ * 与游戏主循环的规则一致：每条命令前先检查是否已在终点，
+ * 移动到墙或边界外时原地不动并计一次撞墙，q 立即结束，其他字符忽略。
+ * 位置以网格下标表示，移动是否合法直接查可移动方向掩码。
+ *
+ * @param maze 指向迷宫结构体的指针，回放不修改迷宫
+ * @param start 回放起点
+ * @param commands 命令缓冲区
+ * @param length 命令数
+ * @param result 输出回放结果
+ */
+void replayCommands(const Maze *maze, Position start, const char *commands, size_t length, ReplayResult *result) {
+    const uint8_t *masks = maze->moveMasks;
+    CellIndex position = MAZE_INDEX(maze, start.row, start.col);
+    CellIndex exitIndex = MAZE_INDEX(maze, maze->exit.row, maze->exit.col);
+    size_t moves = 0;
+    size_t collisions = 0;
+    size_t step = 0;
+    ReplayOutcome outcome = REPLAY_EXHAUSTED;
+
+    for (; step < length; step++) {
+        if (position == exitIndex) {
+            outcome = REPLAY_WON;
+            break;
+        }
+
+        unsigned char command = (unsigned char)commands[step];
+        unsigned char move = COMMAND_MOVE[command];
+        if (move) {
+            // 查可移动方向掩码，不能移动时偏移与0相与
+            int direction = move - 1;
+            size_t open = (masks[position] >> direction) & 1;
+            position += maze->moveOffsets[direction] & -(CellIndex)open;
+            moves += open;
+            collisions += open ^ 1;
+        } else if (command == 'q' || command == 'Q') {
+            // 退出命令本身也计入步数，与 GameSession 一致
+            outcome = REPLAY_QUIT;
+            step++;
+            break;
+        }
+    }
+
+    // 最后一条命令走到终点也算胜利
+    if (outcome == REPLAY_EXHAUSTED && position == exitIndex) {
+        outcome = REPLAY_WON;
+    }
+
+    result->outcome = outcome;
+    result->position.row = (int)(position / maze->stride) - MAZE_PADDING;
+    result->position.col = (int)(position % maze->stride) - MAZE_PADDING;
+    result->steps = step;
+    result->moves = moves;
+    result->collisions = collisions;
+}
+
+#ifdef REPLAY_HAVE_AVX2
+/**
+ * 用 AVX2 同时回放最多 REPLAY_LANES 条命令序列
+ *
+ * 各会话的行列坐标按结构数组存放在向量中，每一步：
+ * 先对已在终点的会话记为胜利，再对 q 记为退出，其余会话计算新位置，
+ * 越界检查与 movePlayer 相同，墙的判断从墙位图中按位收集，最后按掩码更新。
+ */
+__attribute__((target("avx2")))
+static void replayBlockAvx2(const Maze *maze, Position start, const char *const *commands,
+                            const size_t *lengths, int lanes, ReplayResult *results) {
+    const int *walls = (const int*)maze->wallBits;
+    const char *laneCommands[REPLAY_LANES];
+    int32_t laneLengths[REPLAY_LANES];
+    int32_t maxLength = 0;
+    for (int l = 0; l < REPLAY_LANES; l++) {
+        laneCommands[l] = l < lanes ? commands[l] : NULL;
+        laneLengths[l] = l < lanes ? (int32_t)lengths[l] : 0;
+        if (laneLengths[l] > maxLength) {
+            maxLength = laneLengths[l];
+        }
+    }
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i minusOne = _mm256_set1_epi32(-1);
+    const __m256i height = _mm256_set1_epi32(maze->height);
+    const __m256i width = _mm256_set1_epi32(maze->width);
+    const __m256i rowBits = _mm256_set1_epi32(maze->wallWordsPerRow * BITMAP_WORD_BITS);
+    const __m256i exitRow = _mm256_set1_epi32(maze->exit.row);
+    const __m256i exitCol = _mm256_set1_epi32(maze->exit.col);
+    const __m256i length = _mm256_loadu_si256((const __m256i*)laneLengths);
+
+    __m256i row = _mm256_set1_epi32(start.row);
+    __m256i col = _mm256_set1_epi32(start.col);
+    __m256i done = zero;
+    __m256i won = zero;
+    __m256i steps = zero;
+    __m256i moves = zero;
+    __m256i collisions = zero;
+    const __m256i byteMask = _mm256_set1_epi64x(0xFF);
+    const __m256i laneOrder = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    __m256i chunkLow = zero;
+    __m256i chunkHigh = zero;
+
+    for (int32_t t = 0; t < maxLength; t++) {
+        __m256i step = _mm256_set1_epi32(t);
+        __m256i active = _mm256_andnot_si256(done, _mm256_cmpgt_epi32(length, step));
+        if (_mm256_testz_si256(active, active)) {
+            break;
+        }
+
+        // 每条命令前先检查是否已在终点
+        __m256i atExit = _mm256_and_si256(active, _mm256_and_si256(_mm256_cmpeq_epi32(row, exitRow),
+                                                                   _mm256_cmpeq_epi32(col, exitCol)));
+        won = _mm256_or_si256(won, atExit);
+        steps = _mm256_blendv_epi8(steps, step, atExit);
+        done = _mm256_or_si256(done, atExit);
+        active = _mm256_andnot_si256(atExit, active);
+
+        // 每8步为各会话一次读入8条命令，之后每步移位取出一个字节
+        if ((t & 7) == 0) {
+            uint64_t chunk[REPLAY_LANES];
+            for (int l = 0; l < REPLAY_LANES; l++) {
+                chunk[l] = 0;
+                if (t + 8 <= laneLengths[l]) {
+                    memcpy(&chunk[l], laneCommands[l] + t, sizeof(uint64_t));
+                } else if (t < laneLengths[l]) {
+                    memcpy(&chunk[l], laneCommands[l] + t, (size_t)(laneLengths[l] - t));
+                }
+            }
+            chunkLow = _mm256_loadu_si256((const __m256i*)chunk);
+            chunkHigh = _mm256_loadu_si256((const __m256i*)(chunk + 4));
+        }
+        __m128i shift = _mm_cvtsi32_si128((t & 7) * 8);
+        __m256i low = _mm256_and_si256(_mm256_srl_epi64(chunkLow, shift), byteMask);
+        __m256i high = _mm256_and_si256(_mm256_srl_epi64(chunkHigh, shift), byteMask);
+        // 交错后为会话 0,4,1,5,2,6,3,7 的顺序，再重排回 0..7
+        __m256i command = _mm256_permutevar8x32_epi32(
+            _mm256_blend_epi32(low, _mm256_slli_epi64(high, 32), 0xAA), laneOrder);
+
+        // q 结束回放，q 本身计入步数
+        __m256i lower = _mm256_or_si256(command, _mm256_set1_epi32(0x20));
+        __m256i isQuit = _mm256_and_si256(active, _mm256_cmpeq_epi32(lower, _mm256_set1_epi32('q')));
+        steps = _mm256_blendv_epi8(steps, _mm256_add_epi32(step, one), isQuit);
+        done = _mm256_or_si256(done, isQuit);
+        active = _mm256_andnot_si256(isQuit, active);
+
+        // 比较结果为-1，相减即得到行列增量
+        __m256i isUp = _mm256_cmpeq_epi32(lower, _mm256_set1_epi32('w'));
+        __m256i isDown = _mm256_cmpeq_epi32(lower, _mm256_set1_epi32('s'));
+        __m256i isLeft = _mm256_cmpeq_epi32(lower, _mm256_set1_epi32('a'));
+        __m256i isRight = _mm256_cmpeq_epi32(lower, _mm256_set1_epi32('d'));
+        __m256i isMove = _mm256_and_si256(active, _mm256_or_si256(_mm256_or_si256(isUp, isDown),
+                                                                  _mm256_or_si256(isLeft, isRight)));
+        __m256i newRow = _mm256_add_epi32(row, _mm256_sub_epi32(isUp, isDown));
+        __m256i newCol = _mm256_add_epi32(col, _mm256_sub_epi32(isLeft, isRight));
+
+        // 越界视为撞墙，界内的格子从墙位图中收集对应的32位字再取出该位
+        __m256i inBounds = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpgt_epi32(newRow, minusOne), _mm256_cmpgt_epi32(height, newRow)),
+            _mm256_and_si256(_mm256_cmpgt_epi32(newCol, minusOne), _mm256_cmpgt_epi32(width, newCol)));
+        __m256i lookup = _mm256_and_si256(isMove, inBounds);
+        __m256i bit = _mm256_add_epi32(_mm256_mullo_epi32(newRow, rowBits), newCol);
+        __m256i word = _mm256_mask_i32gather_epi32(zero, walls, _mm256_srli_epi32(bit, 5), lookup, 4);
+        __m256i wallBit = _mm256_and_si256(_mm256_srlv_epi32(word, _mm256_and_si256(bit, _mm256_set1_epi32(31))), one);
+        __m256i open = _mm256_andnot_si256(_mm256_cmpeq_epi32(wallBit, one), lookup);
+        __m256i blocked = _mm256_andnot_si256(open, isMove);
+
+        row = _mm256_blendv_epi8(row, newRow, open);
+        col = _mm256_blendv_epi8(col, newCol, open);
+        moves = _mm256_sub_epi32(moves, open);
+        collisions = _mm256_sub_epi32(collisions, blocked);
+    }
+
+    int32_t laneRow[REPLAY_LANES], laneCol[REPLAY_LANES], laneDone[REPLAY_LANES], laneWon[REPLAY_LANES];
+    int32_t laneSteps[REPLAY_LANES], laneMoves[REPLAY_LANES], laneCollisions[REPLAY_LANES];
+    _mm256_storeu_si256((__m256i*)laneRow, row);
+    _mm256_storeu_si256((__m256i*)laneCol, col);
+    _mm256_storeu_si256((__m256i*)laneDone, done);
+    _mm256_storeu_si256((__m256i*)laneWon, won);
+    _mm256_storeu_si256((__m256i*)laneSteps, steps);
+    _mm256_storeu_si256((__m256i*)laneMoves, moves);
+    _mm256_storeu_si256((__m256i*)laneCollisions, collisions);
+
+    for (int l = 0; l < lanes; l++) {
+        ReplayResult *result = &results[l];
+        result->position.row = laneRow[l];
+        result->position.col = laneCol[l];
+        result->moves = (size_t)laneMoves[l];
+        result->collisions = (size_t)laneCollisions[l];
+        if (laneDone[l]) {
+            result->outcome = laneWon[l] ? REPLAY_WON : REPLAY_QUIT;
+            result->steps = (size_t)laneSteps[l];
+        } else {
+            // 命令用完，最后一条命令走到终点也算胜利
+            bool atExit = laneRow[l] == maze->exit.row && laneCol[l] == maze->exit.col;
+            result->outcome = atExit ? REPLAY_WON : REPLAY_EXHAUSTED;
+            result->steps = lengths[l];
+        }
+    }
+}
+
+/**
+ * 检查迷宫能否用 AVX2 批量回放：需要墙位图，位下标不超过32位，且CPU支持 AVX2
+ */
+static bool canReplayWithAvx2(const Maze *maze) {
+    int64_t bits = (int64_t)maze->wallWordsPerRow * BITMAP_WORD_BITS * maze->height;
+    return maze->wallBits && bits <= INT32_MAX && __builtin_cpu_supports("avx2");
+}
+#endif
+
+/**
+ * 从同一位置同时回放多条命令序列
+ *
+ * 每 REPLAY_LANES 条命令序列为一组按步同时推进，结果与逐条调用 replayCommands 相同。
+ * CPU 不支持 AVX2 或迷宫过大时逐条回放。
+ *
+ * @param maze 指向迷宫结构体的指针，回放不修改迷宫
+ * @param start 所有会话的回放起点
+ * @param commands 每个会话的命令缓冲区
+ * @param lengths 每个会话的命令数
+ * @param count 会话数
+ * @param results 输出每个会话的回放结果
+ */
+void replayCommandsBulk(const Maze *maze, Position start, const char *const *commands,
+                        const size_t *lengths, size_t count, ReplayResult *results) {
+#ifdef REPLAY_HAVE_AVX2
+    bool vectorized = canReplayWithAvx2(maze);
+#else
+    bool vectorized = false;
+#endif
+
+    for (size_t first = 0; first < count; first += REPLAY_LANES) {
+        int lanes = count - first < REPLAY_LANES ? (int)(count - first) : REPLAY_LANES;
+
+        // 向量路径的计数为32位，超长的命令序列所在的组逐条回放
+        bool blockVectorized = vectorized;
+        for (int l = 0; l < lanes; l++) {
+            if (lengths[first + l] > INT32_MAX) {
+                blockVectorized = false;
+            }
+        }
+
+#ifdef REPLAY_HAVE_AVX2
+        if (blockVectorized) {
+            replayBlockAvx2(maze, start, commands + first, lengths + first, lanes, results + first);
+            continue;
+        }
+#endif
+        for (int l = 0; l < lanes; l++) {
+            replayCommands(maze, start, commands[first + l], lengths[first + l], &results[first + l]);
+        }
+    }
+}
+
+/**
+ * 从玩家当前位置回放指令文件
+ *
+ * @param maze 指向迷宫结构体的指针
+ * @param filename 指令文件名
+ * @param result 输出回放结果
+ * @return 成功返回true，指令文件无法读取时返回false
+ */
+bool replayInstructionFile(const Maze *maze, const char *filename, ReplayResult *result) {
+    char *commands = loadInstructions(filename);
+    if (!commands) {
+        return false;
+    }
+
+    replayCommands(maze, maze->player, commands, strlen(commands), result);
+    free(commands);
+    return true;
+}
+
+/**
+ * 检查命令行是否请求回放模式
+ *
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数
+ * @return 第一个参数是回放模式选项时返回true
+ */
+bool isReplayCommandLine(int argc, char *argv[]) {
+    return argc >= 2 && strcmp(argv[1], REPLAY_MODE_OPTION) == 0;
+}
+
+/**
+ * 运行回放模式
+ *
+ * 用法：<程序> --replay <迷宫文件> <宽度> <高度> <指令文件> [--large]
+ * 输出一行结果：结束原因、处理的命令数、最终位置、移动次数和撞墙次数。
+ *
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数
+ * @return 成功返回0，否则返回1
+ */
+int runReplayMode(int argc, char *argv[]) {
+    if (argc != 6 && argc != 7) {
+        printf("错误：命令行参数数量不正确\n");
+        printf("用法: %s %s <迷宫文件> <宽度> <高度> <指令文件> [--large]\n", argv[0], REPLAY_MODE_OPTION);
+        return 1;
+    }
+
+    // 迷宫参数与单文件模式相同，复用同一套验证
+    char *mazeArgs[] = {argv[0], argv[2], argv[3], argv[4], argc == 7 ? argv[6] : NULL};
+    if (!validateCommandLine(argc - 2, mazeArgs)) {
+        return 1;
+    }
+
+    Maze *maze = createMaze(argv[2], atoi(argv[3]), atoi(argv[4]));
+    if (!maze) {
+        return 1;
+    }
+
+    ReplayResult result;
+    if (!replayInstructionFile(maze, argv[5], &result)) {
+        freeMaze(maze);
+        return 1;
+    }
+
+    static const char *const OUTCOME_NAMES[] = {"exhausted", "won", "quit"};
+    printf("outcome=%s steps=%zu row=%d col=%d moves=%zu collisions=%zu\n",
+           OUTCOME_NAMES[result.outcome], result.steps, result.position.row, result.position.col,
+           result.moves, result.collisions);
+
+    freeMaze(maze);
+    return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "maze.h"
+
+// 开启回放模式的命令行选项
+#define REPLAY_MODE_OPTION "--replay"
+
+// 回放结束的原因
+typedef enum {
+    REPLAY_EXHAUSTED,   // 命令用完仍未到达终点
+    REPLAY_WON,         // 到达终点
+    REPLAY_QUIT         // 遇到退出命令
+} ReplayOutcome;
+
+// 回放结果
+typedef struct {
+    ReplayOutcome outcome;  // 结束原因
+    Position position;      // 最终位置
+    size_t steps;           // 处理过的命令数，含退出命令；胜利时为走到终点的那条命令为止
+    size_t moves;           // 成功移动的次数
+    size_t collisions;      // 撞墙或越界的次数
+} ReplayResult;
+
+// 从指定位置回放命令缓冲区，不做任何终端输入输出
+void replayCommands(const Maze *maze, Position start, const char *commands, size_t length, ReplayResult *result);
+
+// 批量回放时同时推进的会话数
+#define REPLAY_LANES 8
+
+// 从同一位置同时回放多条命令序列，结果与逐条调用 replayCommands 相同
+void replayCommandsBulk(const Maze *maze, Position start, const char *const *commands,
+                        const size_t *lengths, size_t count, ReplayResult *results);
+
+// 从玩家当前位置回放指令文件
+bool replayInstructionFile(const Maze *maze, const char *filename, ReplayResult *result);
+
+// 检查命令行是否请求回放模式
+bool isReplayCommandLine(int argc, char *argv[]);
+
+// 运行回放模式，返回程序退出码
+int runReplayMode(int argc, char *argv[]);
+
+#endif /* REPLAY_H */
@@ -0,0 +1,570 @@
+/*
+ * 寻路引擎一致性测试
+ *
+ * 以 bfsShortestDistance 为基准，在 test_data/valid_mazes 中能加载的迷宫和按种子生成的随机迷宫上，
+ * 比较双向BFS、A*、跳点搜索、位图BFS、多线程BFS、走廊图和分层寻路给出的最短距离，
+ * 并把各引擎给出的路径逐步回放，检查每一步都可通行、终点正确且步数等于最短距离。
+ * 同时检查到终点的距离表、连通区域标号、批量回放与逐条回放的结果和编辑器的增量可达性。
+ *
+ * 编译与运行（在仓库根目录）：
+ *   gcc -std=c11 -O2 -DMAZE_NO_MAIN -I. -o test_engines tests/test_engines.c *.c -lpthread -lm
+ *   ./test_engines [随机迷宫数] [种子]
+ *
+ * 全部通过返回0，否则返回1。
+ */
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "maze.h"
+#include "maze_operations.h"
+#include "path_finder.h"
+#include "parallel_bfs.h"
+#include "input_validator.h"
+#include "distance_field.h"
+#include "maze_editor.h"
+#include "maze_regions.h"
+#include "corridor_graph.h"
+#include "hierarchical_planner.h"
+#include "replay.h"
+
+// 测试数据目录
+#define VALID_MAZE_DIR "test_data/valid_mazes"
+
+// 默认的随机迷宫数
+#define DEFAULT_RANDOM_MAZES 60
+
+// 每个迷宫随机抽取的位置对数
+#define PAIRS_PER_MAZE 40
+
+// 每个迷宫随机修改的格子数
+#define EDITS_PER_MAZE 60
+
+// 每个迷宫批量回放的命令序列数，不是 REPLAY_LANES 的整数倍，最后一组不满
+#define REPLAY_SEQUENCES (3 * REPLAY_LANES + 3)
+
+// 随机迷宫的最大边长，超过100的迷宫需要大迷宫模式
+#define RANDOM_MAZE_MAX_SIZE 160
+
+// 同一个迷宫上各引擎共用的状态
+typedef struct {
+    Maze* maze;
+    const char* name;           // 迷宫名称，失败时输出
+    BfsWorkspace workspace;
+    CorridorGraph corridors;
+    CorridorSearch corridorSearch;
+    HierarchicalPlanner smallPlanner;   // 小区块，路线跨越很多区块
+    HierarchicalPlanner planner;        // 默认区块大小
+    HierarchicalSearch plannerSearch;
+    char* commands;             // 路径命令缓冲区
+    int capacity;               // 缓冲区能容纳的步数
+} EngineContext;
+
+static int failures = 0;
+static long checkedPairs = 0;
+static long replayedSequences = 0;
+
+// 检查失败时输出原因并计数
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            failures++; \
+            printf("失败：%s: ", context->name); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+/**
+ * 可复现的伪随机数（xorshift64）
+ */
+static uint64_t nextRandom(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+/**
+ * 0 到 bound - 1 之间的随机整数
+ */
+static int randomBelow(uint64_t *state, int bound) {
+    return (int)(nextRandom(state) % (uint64_t)bound);
+}
+
+/**
+ * 迷宫中随机的可通行格子
+ */
+static Position randomOpenCell(const Maze *maze, uint64_t *state) {
+    for (;;) {
+        Position pos = {randomBelow(state, maze->height), randomBelow(state, maze->width)};
+        if (IS_OPEN_CELL(MAZE_CELL(maze, pos.row, pos.col))) {
+            return pos;
+        }
+    }
+}
+
+/**
+ * 按可移动方向掩码逐步回放路径
+ *
+ * @return 每一步都可通行且停在终点时返回步数，否则返回-1
+ */
+static int replayPath(const Maze *maze, const MazePath *path, Position end) {
+    PathIterator iterator;
+    initPathIterator(&iterator, path);
+    Position current = path->start;
+    Position next;
+    char command;
+    int steps = 0;
+
+    while (nextPathStep(&iterator, &next, &command)) {
+        Direction dir;
+        switch (command) {
+            case 'w': dir = UP; break;
+            case 's': dir = DOWN; break;
+            case 'a': dir = LEFT; break;
+            case 'd': dir = RIGHT; break;
+            default: return -1;
+        }
+        if (!(maze->moveMasks[MAZE_INDEX(maze, current.row, current.col)] & MOVE_BIT(dir))) {
+            return -1;
+        }
+        current = next;
+        steps++;
+    }
+    return isSamePosition(current, end) ? steps : -1;
+}
+
+/**
+ * 检查一条引擎给出的路径：能找到当且仅当可达，回放步数等于最短距离
+ */
+static void checkPath(EngineContext *context, const char *engine, bool found, const MazePath *path,
+                      Position start, Position end, int expected) {
+    CHECK(found == (expected >= 0), "%s 路径 (%d,%d)->(%d,%d) 找到=%d，基准距离 %d",
+          engine, start.row, start.col, end.row, end.col, found, expected);
+    if (found && expected >= 0) {
+        int steps = replayPath(context->maze, path, end);
+        CHECK(steps == expected, "%s 路径 (%d,%d)->(%d,%d) 回放 %d 步，基准距离 %d",
+              engine, start.row, start.col, end.row, end.col, steps, expected);
+    }
+}
+
+/**
+ * 在一对位置上比较所有引擎
+ */
+static void checkPair(EngineContext *context, Position start, Position end) {
+    Maze *maze = context->maze;
+    int expected = bfsShortestDistance(maze, &context->workspace, start, end);
+    checkedPairs++;
+
+    struct {
+        const char* engine;
+        int distance;
+    } distances[] = {
+        {"双向BFS", bfsShortestDistanceBidirectional(maze, &context->workspace, start, end)},
+        {"A*", aStarShortestDistance(maze, &context->workspace, start, end)},
+        {"跳点搜索", jumpPointShortestDistance(maze, &context->workspace, start, end)},
+        {"位图BFS", bfsShortestDistanceBitmap(maze, start, end)},
+        {"单线程并行BFS", parallelShortestDistance(maze, start, end, 1)},
+        {"三线程并行BFS", parallelShortestDistance(maze, start, end, 3)},
+        {"走廊图", corridorShortestDistance(&context->corridors, &context->corridorSearch, start, end)},
+        {"分层寻路(小区块)", hierarchicalShortestDistance(&context->smallPlanner, &context->plannerSearch, start, end)},
+        {"分层寻路", hierarchicalShortestDistance(&context->planner, &context->plannerSearch, start, end)},
+    };
+    for (size_t i = 0; i < sizeof(distances) / sizeof(distances[0]); i++) {
+        CHECK(distances[i].distance == expected, "%s (%d,%d)->(%d,%d) 距离 %d，基准距离 %d", distances[i].engine,
+              start.row, start.col, end.row, end.col, distances[i].distance, expected);
+    }
+
+    MazePath path;
+    initMazePath(&path, context->commands, context->capacity);
+    checkPath(context, "BFS", findShortestPathWith(maze, &context->workspace, start, end, &path),
+              &path, start, end, expected);
+    initMazePath(&path, context->commands, context->capacity);
+    checkPath(context, "跳点搜索", findShortestPathJumpPoint(maze, &context->workspace, start, end, &path),
+              &path, start, end, expected);
+    initMazePath(&path, context->commands, context->capacity);
+    checkPath(context, "走廊图", findShortestPathCorridor(&context->corridors, &context->corridorSearch, start, end, &path),
+              &path, start, end, expected);
+    initMazePath(&path, context->commands, context->capacity);
+    checkPath(context, "分层寻路(小区块)",
+              findShortestPathHierarchical(&context->smallPlanner, &context->plannerSearch, start, end, &path),
+              &path, start, end, expected);
+    initMazePath(&path, context->commands, context->capacity);
+    checkPath(context, "分层寻路", findShortestPathHierarchical(&context->planner, &context->plannerSearch, start, end, &path),
+              &path, start, end, expected);
+}
+
+/**
+ * 检查到终点的距离表和提示方向
+ */
+static void checkDistanceField(EngineContext *context, uint64_t *state) {
+    Maze *maze = context->maze;
+    CHECK(buildExitDistances(maze), "距离表内存分配失败");
+    for (int k = 0; k < PAIRS_PER_MAZE; k++) {
+        Position pos = randomOpenCell(maze, state);
+        int expected = bfsShortestDistance(maze, &context->workspace, pos, maze->exit);
+        int distance = distanceToExit(maze, pos);
+        CHECK(distance == expected, "距离表 (%d,%d) 为 %d，基准距离 %d", pos.row, pos.col, distance, expected);
+
+        Direction dir;
+        bool hinted = nextHintMove(maze, pos, &dir);
+        CHECK(hinted == (expected > 0), "提示 (%d,%d) 给出=%d，基准距离 %d", pos.row, pos.col, hinted, expected);
+        if (hinted) {
+            Position next = pos;
+            bool moved = movePosition(maze, &next, dir) != MOVE_BLOCKED;
+            CHECK(moved && distanceToExit(maze, next) == expected - 1,
+                  "提示 (%d,%d) 的方向没有靠近终点", pos.row, pos.col);
+        }
+    }
+}
+
+/**
+ * 检查连通区域标号：两格同区域当且仅当互相可达，结果与线程数无关
+ */
+static void checkRegions(EngineContext *context, uint64_t *state) {
+    Maze *maze = context->maze;
+    MazeRegions single;
+    MazeRegions banded;
+    if (!labelMazeRegions(maze, &single, 1) || !labelMazeRegions(maze, &banded, 3)) {
+        CHECK(false, "区域标号内存分配失败");
+        return;
+    }
+    CHECK(single.count == banded.count && single.labelCount == banded.labelCount &&
+          memcmp(single.labels, banded.labels, single.labelCount * sizeof(uint32_t)) == 0,
+          "区域标号与线程数有关");
+
+    size_t total = 0;
+    for (uint32_t k = 0; k < single.count; k++) {
+        total += single.regions[k].size;
+    }
+    CHECK(total == single.openCells, "各区域格子数之和 %zu 不等于可通行格子数 %zu", total, single.openCells);
+
+    for (int k = 0; k < PAIRS_PER_MAZE; k++) {
+        Position a = randomOpenCell(maze, state);
+        Position b = randomOpenCell(maze, state);
+        bool connected = bfsShortestDistance(maze, &context->workspace, a, b) >= 0;
+        bool sameRegion = regionAt(&single, maze, a) == regionAt(&single, maze, b);
+        CHECK(connected == sameRegion, "(%d,%d) 与 (%d,%d) 可达=%d，同区域=%d",
+              a.row, a.col, b.row, b.col, connected, sameRegion);
+        bool reachable = bfsShortestDistance(maze, &context->workspace, maze->start, a) >= 0;
+        CHECK(isDeadCell(&single, maze, a) == !reachable, "(%d,%d) 死格子判断错误", a.row, a.col);
+    }
+    freeMazeRegions(&single);
+    freeMazeRegions(&banded);
+}
+
+/**
+ * 随机的回放命令：多数是大小写混合的移动，夹杂不移动的字符，quitChance 不为0时以约 1/quitChance 的概率为 q 或 Q
+ */
+static char randomReplayCommand(uint64_t *state, int quitChance) {
+    static const char MOVES[] = "wasdWASD";
+    static const char OTHERS[] = "mhx \n\x91";
+    if (quitChance && randomBelow(state, quitChance) == 0) {
+        return randomBelow(state, 2) ? 'q' : 'Q';
+    }
+    if (randomBelow(state, 8) == 0) {
+        return OTHERS[randomBelow(state, (int)sizeof(OTHERS) - 1)];
+    }
+    return MOVES[randomBelow(state, 8)];
+}
+
+/**
+ * 比较批量回放与逐条回放：结束原因、步数、位置、移动和撞墙次数都必须相同
+ *
+ * 随机序列长度各不相同，各组中的会话在不同的步结束；随机游走会撞墙，四周无墙的迷宫还会越界。
+ * 开头几条序列从起点沿最短路径走到终点：恰好在最后一条命令胜利、胜利后仍有命令、以及在中途退出。
+ */
+static void checkReplay(EngineContext *context, uint64_t *state) {
+    Maze *maze = context->maze;
+    int maxLength = 2 * (maze->width + maze->height) + 13;
+    char *buffer = (char*)malloc((size_t)REPLAY_SEQUENCES * (size_t)(maxLength + context->capacity + 1));
+    if (!buffer) {
+        CHECK(false, "回放内存分配失败");
+        return;
+    }
+
+    MazePath path;
+    initMazePath(&path, context->commands, context->capacity);
+    bool reachable = findShortestPathWith(maze, &context->workspace, maze->start, maze->exit, &path);
+
+    const char *commands[REPLAY_SEQUENCES];
+    size_t lengths[REPLAY_SEQUENCES];
+    char *next = buffer;
+    for (int k = 0; k < REPLAY_SEQUENCES; k++) {
+        size_t length = 0;
+        if (reachable && k < 3) {
+            // 最短路径，随机改为大写
+            for (int i = 0; i < path.length; i++) {
+                char c = path.commands[i];
+                next[length++] = randomBelow(state, 2) ? (char)(c - 'a' + 'A') : c;
+            }
+            if (k == 1) {
+                next[length++] = 'd';
+                next[length++] = 'q';
+            } else if (k == 2 && length > 0) {
+                next[randomBelow(state, (int)length)] = 'Q';
+            }
+        } else {
+            // 一半的序列不含退出命令
+            int quitChance = k % 2 ? 0 : maxLength;
+            length = (size_t)randomBelow(state, maxLength + 1);
+            for (size_t i = 0; i < length; i++) {
+                next[i] = randomReplayCommand(state, quitChance);
+            }
+        }
+        commands[k] = next;
+        lengths[k] = length;
+        next += length;
+    }
+
+    ReplayResult bulk[REPLAY_SEQUENCES];
+    replayCommandsBulk(maze, maze->start, commands, lengths, REPLAY_SEQUENCES, bulk);
+    for (int k = 0; k < REPLAY_SEQUENCES; k++) {
+        ReplayResult expected;
+        replayCommands(maze, maze->start, commands[k], lengths[k], &expected);
+        ReplayResult *actual = &bulk[k];
+        CHECK(actual->outcome == expected.outcome && actual->steps == expected.steps &&
+              isSamePosition(actual->position, expected.position) &&
+              actual->moves == expected.moves && actual->collisions == expected.collisions,
+              "第%d条回放（%zu 条命令）批量为 %d/%zu/(%d,%d)/%zu/%zu，逐条为 %d/%zu/(%d,%d)/%zu/%zu",
+              k, lengths[k], actual->outcome, actual->steps, actual->position.row, actual->position.col,
+              actual->moves, actual->collisions, expected.outcome, expected.steps, expected.position.row,
+              expected.position.col, expected.moves, expected.collisions);
+        replayedSequences++;
+    }
+
+    if (reachable) {
+        // 恰好在最后一条命令到达终点，以及到达后剩余的命令不再处理
+        CHECK(bulk[0].outcome == REPLAY_WON && bulk[0].steps == (size_t)path.length,
+              "沿最短路径回放的结果为 %d，步数 %zu", bulk[0].outcome, bulk[0].steps);
+        CHECK(bulk[1].outcome == REPLAY_WON && bulk[1].steps == (size_t)path.length,
+              "到达终点后的命令被处理，步数 %zu", bulk[1].steps);
+    }
+    free(buffer);
+}
+
+/**
+ * 随机加墙和拆墙，每次修改后比较编辑器维护的可达性与重新搜索的结果
+ *
+ * 会修改迷宫，放在最后检查。
+ */
+static void checkEditor(EngineContext *context, uint64_t *state) {
+    Maze *maze = context->maze;
+    MazeEditor editor;
+    if (!openMazeEditor(&editor, maze)) {
+        CHECK(false, "编辑器内存分配失败");
+        return;
+    }
+    for (int k = 0; k < EDITS_PER_MAZE; k++) {
+        Position pos = {randomBelow(state, maze->height), randomBelow(state, maze->width)};
+        if (isSamePosition(pos, maze->start) || isSamePosition(pos, maze->exit)) {
+            continue;
+        }
+        char c = randomBelow(state, 2) ? WALL_CHAR : PATH_CHAR;
+        CHECK(setMazeCell(&editor, pos, c), "修改格子 (%d,%d) 失败", pos.row, pos.col);
+        bool expected = bfsShortestDistance(maze, &context->workspace, maze->start, maze->exit) >= 0;
+        CHECK(isExitReachableInEditor(&editor) == expected, "第%d次修改 (%d,%d) 为 '%c' 后可达性不一致",
+              k + 1, pos.row, pos.col, c);
+    }
+    closeMazeEditor(&editor);
+}
+
+/**
+ * 在一个迷宫上运行全部检查
+ */
+static void checkMaze(Maze *maze, const char *name, uint64_t seed) {
+    EngineContext engines;
+    EngineContext *context = &engines;
+    memset(context, 0, sizeof(EngineContext));
+    context->maze = maze;
+    context->name = name;
+    context->capacity = maze->width * maze->height;
+    context->commands = (char*)malloc((size_t)context->capacity);
+    initBfsWorkspace(&context->workspace);
+    initCorridorSearch(&context->corridorSearch);
+    initHierarchicalSearch(&context->plannerSearch);
+    if (!context->commands || !buildCorridorGraph(&context->corridors, maze) ||
+        !buildHierarchicalPlanner(&context->smallPlanner, maze, 4, 2) ||
+        !buildHierarchicalPlanner(&context->planner, maze, HPA_DEFAULT_CLUSTER_SIZE, HPA_AUTO_THREADS)) {
+        printf("失败：%s: 内存分配失败\n", name);
+        exit(1);
+    }
+
+    uint64_t state = seed * 2654435761u + 1;
+    checkPair(context, maze->start, maze->exit);
+    checkPair(context, maze->exit, maze->start);
+    for (int k = 0; k < PAIRS_PER_MAZE; k++) {
+        Position a = randomOpenCell(maze, &state);
+        Position b = k % 8 == 0 ? a : randomOpenCell(maze, &state);
+        checkPair(context, a, b);
+    }
+    checkDistanceField(context, &state);
+    checkRegions(context, &state);
+    checkReplay(context, &state);
+
+    freeHierarchicalSearch(&context->plannerSearch);
+    freeHierarchicalPlanner(&context->planner);
+    freeHierarchicalPlanner(&context->smallPlanner);
+    freeCorridorSearch(&context->corridorSearch);
+    freeCorridorGraph(&context->corridors);
+
+    // 编辑器会改动迷宫，之前建立的图和寻路器已释放
+    checkEditor(context, &state);
+    freeBfsWorkspace(&context->workspace);
+    free(context->commands);
+}
+
+/**
+ * 由文件内容推算迷宫宽高：宽度为第一行的长度，高度为行数
+ */
+static bool measureMazeFile(const char *path, int *width, int *height) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    int c;
+    int column = 0;
+    *width = -1;
+    *height = 0;
+    while ((c = fgetc(file)) != EOF) {
+        if (c == '\n') {
+            if (*width < 0) {
+                *width = column;
+            }
+            (*height)++;
+            column = 0;
+        } else if (c != '\r') {
+            column++;
+        }
+    }
+    if (column > 0) {
+        if (*width < 0) {
+            *width = column;
+        }
+        (*height)++;
+    }
+    fclose(file);
+    return *width > 0;
+}
+
+/**
+ * 检查测试数据目录中能加载的迷宫，加载失败的跳过
+ */
+static int checkDataMazes(void) {
+    DIR *dir = opendir(VALID_MAZE_DIR);
+    if (!dir) {
+        printf("警告：找不到测试数据目录 %s\n", VALID_MAZE_DIR);
+        return 0;
+    }
+    int checked = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", VALID_MAZE_DIR, entry->d_name);
+        int width;
+        int height;
+        if (!measureMazeFile(path, &width, &height)) {
+            continue;
+        }
+        Maze *maze = createMaze(path, width, height);
+        if (!maze) {
+            printf("跳过：%s 无法加载\n", path);
+            continue;
+        }
+        checkMaze(maze, path, (uint64_t)checked + 1);
+        freeMaze(maze);
+        checked++;
+    }
+    closedir(dir);
+    return checked;
+}
+
+/**
+ * 生成随机迷宫文件并加载
+ *
+ * 墙的密度在 0 到 45% 之间，一部分迷宫四周没有墙；奇数种子用 CRLF 行尾，走逐行复制的加载路径。
+ */
+static Maze* createRandomMaze(uint64_t seed, char *name, size_t nameSize) {
+    uint64_t state = seed * 0x9E3779B97F4A7C15ull + 7;
+    int width = MIN_MAZE_SIZE + randomBelow(&state, RANDOM_MAZE_MAX_SIZE - MIN_MAZE_SIZE + 1);
+    int height = MIN_MAZE_SIZE + randomBelow(&state, RANDOM_MAZE_MAX_SIZE - MIN_MAZE_SIZE + 1);
+    int density = randomBelow(&state, 46);
+    bool bordered = randomBelow(&state, 2);
+    const char *newline = seed % 2 ? "\r\n" : "\n";
+    snprintf(name, nameSize, "随机迷宫 #%llu (%dx%d，墙 %d%%)", (unsigned long long)seed, width, height, density);
+
+    char *grid = (char*)malloc((size_t)width * height);
+    if (!grid) {
+        return NULL;
+    }
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            bool border = i == 0 || j == 0 || i == height - 1 || j == width - 1;
+            grid[i * width + j] = (bordered && border) || randomBelow(&state, 100) < density ? WALL_CHAR : PATH_CHAR;
+        }
+    }
+    int start = randomBelow(&state, width * height);
+    int exit = randomBelow(&state, width * height - 1);
+    if (exit >= start) {
+        exit++;
+    }
+    grid[start] = START_CHAR;
+    grid[exit] = EXIT_CHAR;
+
+    char path[] = "/tmp/test_engines_XXXXXX";
+    int fd = mkstemp(path);
+    FILE *file = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!file) {
+        free(grid);
+        return NULL;
+    }
+    for (int i = 0; i < height; i++) {
+        fwrite(grid + (size_t)i * width, 1, (size_t)width, file);
+        fputs(newline, file);
+    }
+    fclose(file);
+    free(grid);
+
+    Maze *maze = createMaze(path, width, height);
+    unlink(path);
+    return maze;
+}
+
+/**
+ * 主函数
+ *
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数：随机迷宫数、种子
+ * @return 全部通过返回0，否则返回1
+ */
+int main(int argc, char *argv[]) {
+    int randomMazes = argc > 1 ? atoi(argv[1]) : DEFAULT_RANDOM_MAZES;
+    uint64_t seed = argc > 2 ? strtoull(argv[2], NULL, 10) : 1;
+
+    // 随机迷宫可能超过100的上限
+    setMazeSizeLimits(MIN_MAZE_SIZE, UNLIMITED_MAZE_SIZE);
+
+    int dataMazes = checkDataMazes();
+    for (int k = 0; k < randomMazes; k++) {
+        char name[128];
+        Maze *maze = createRandomMaze(seed + (uint64_t)k, name, sizeof(name));
+        if (!maze) {
+            printf("失败：%s 无法加载\n", name);
+            failures++;
+            continue;
+        }
+        checkMaze(maze, name, seed + (uint64_t)k);
+        freeMaze(maze);
+    }
+
+    printf("%d 个测试数据迷宫，%d 个随机迷宫，%ld 对位置，%ld 条回放序列，失败 %d 项\n",
+           dataMazes, randomMazes, checkedPairs, replayedSequences, failures);
+    return failures == 0 ? 0 : 1;
+}